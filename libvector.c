@@ -0,0 +1,960 @@
+/* Filename: libvector.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Dynamic vector store (+ CSV) and math behind libvector.h.
+ *              Everything a store owns hangs off its vl_store handle; there
+ *              is no file-level mutable state.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <math.h>
+#include "libvector.h"
+#include "vector_mem.h"
+#include "vector_cpu.h"
+
+#define DEFAULT_CHUNK_SHIFT 12   /* 4096 vectors = 256 KiB per chunk */
+#define MAX_CHUNK_SHIFT     24
+
+/* Chunks and the name index are reference counted so workspaces and
+ * checkpoints can share them; a writer copies a shared one first.
+ * mag caches |v| per slot (NAN = not computed). It is derived from the
+ * vectors, so readers may fill it in even while the chunk is shared. */
+typedef struct {
+    MemBlock mem;
+    double  *mag;
+    int      refs;
+} Chunk;
+
+typedef struct {
+    size_t *slots;         /* open-addressing name -> slot+1, 0 = empty */
+    size_t  cap;           /* power of two, kept at least 2x size */
+    int     refs;
+} NameIndex;
+
+/* Vectors live in fixed-size chunks. Growing adds a chunk (and maybe grows
+ * the small chunk directory), so existing vectors are never copied. */
+typedef struct {
+    vl_store *db;          /* owner: chunk policy and epoch counter */
+    Chunk   **chunks;      /* directory */
+    size_t    nchunks;
+    size_t    dircap;
+    unsigned  shift;       /* log2(vectors per chunk) */
+    size_t    size;
+    NameIndex *index;      /* NULL until the first insert */
+    unsigned long epoch;   /* new value whenever existing slots move or vanish */
+} VecStore;
+
+typedef struct {
+    char     tag[NAME_LEN];
+    VecStore snap;
+} Checkpoint;
+
+typedef struct {
+    char        name[NAME_LEN];
+    VecStore    store;
+    Checkpoint *cps;
+    size_t      ncps, capcps;
+} Workspace;
+
+struct vl_store {
+    Workspace   **ws;
+    size_t        nws, capws;
+    Workspace    *cur;
+    unsigned long epoch_seq;
+    vl_fallback_fn fallback;
+    void         *fallback_ctx;
+    unsigned      policy_shift;   /* growth policy for new chunks */
+    int           policy_huge;
+};
+
+/* The current workspace's store. */
+#define CUR(db) (&(db)->cur->store)
+
+/* Nothing here exits on out-of-memory: allocations are checked and the
+ * failure goes back to the caller as VL_ENOMEM / VL_ERROR / NULL, with the
+ * store left consistent (see libvector.h). */
+
+static unsigned long next_epoch(VecStore *s) { return ++s->db->epoch_seq; }
+
+/* ----- Chunks ----- */
+
+/* NULL when memory runs out. */
+static Chunk *chunk_new(const VecStore *s) {
+    Chunk *c = (Chunk*)malloc(sizeof *c);
+    if (!c) return NULL;
+    c->mem = mem_alloc(sizeof(Vec) << s->shift, s->db->policy_huge);
+    c->mag = (double*)malloc(sizeof(double) << s->shift);
+    if (!c->mem.ptr || !c->mag) {
+        mem_free(&c->mem);
+        free(c->mag);
+        free(c);
+        return NULL;
+    }
+    for (size_t i = 0; i < ((size_t)1 << s->shift); ++i) c->mag[i] = NAN;
+    c->refs = 1;
+    return c;
+}
+
+static void chunk_release(Chunk *c) {
+    if (--c->refs) return;
+    mem_free(&c->mem);
+    free(c->mag);
+    free(c);
+}
+
+static const Vec *slot(const VecStore *s, size_t i) {
+    return (const Vec*)s->chunks[i >> s->shift]->mem.ptr + (i & (((size_t)1 << s->shift) - 1));
+}
+
+static double *mag_slot(const VecStore *s, size_t i) {
+    return s->chunks[i >> s->shift]->mag + (i & (((size_t)1 << s->shift) - 1));
+}
+
+/* Private copy of chunk c if another store shares it. Copying is invisible
+ * to readers, so a failure part way through a series leaves nothing to undo. */
+static int chunk_unshare(VecStore *s, size_t c) {
+    Chunk *old = s->chunks[c];
+    if (old->refs == 1) return 1;
+    Chunk *nc = chunk_new(s);
+    if (!nc) return VL_ENOMEM;
+    memcpy(nc->mem.ptr, old->mem.ptr, sizeof(Vec) << s->shift);
+    memcpy(nc->mag, old->mag, sizeof(double) << s->shift);
+    chunk_release(old);
+    s->chunks[c] = nc;
+    return 1;
+}
+
+/* Private copies of every chunk from the one holding slot `first` on, so the
+ * moves that follow cannot fail. */
+static int unshare_from(VecStore *s, size_t first) {
+    for (size_t c = first >> s->shift; c < s->nchunks; ++c)
+        if (chunk_unshare(s, c) < 0) return VL_ENOMEM;
+    return 1;
+}
+
+/* Writable slot: copies the chunk first if another store shares it (NULL
+ * when that copy cannot be made). The cached magnitude is dropped, since
+ * the caller is about to write. */
+static Vec *slot_mut(VecStore *s, size_t i) {
+    if (chunk_unshare(s, i >> s->shift) < 0) return NULL;
+    Chunk *c = s->chunks[i >> s->shift];
+    size_t k = i & (((size_t)1 << s->shift) - 1);
+    c->mag[k] = NAN;
+    return (Vec*)c->mem.ptr + k;
+}
+
+static size_t capacity(const VecStore *s) { return s->nchunks << s->shift; }
+
+/* On failure the chunks added so far stay (as spare capacity). */
+static int ensure_capacity(VecStore *s, size_t need) {
+    while (capacity(s) < need) {
+        if (s->nchunks == s->dircap) {
+            size_t newcap = s->dircap ? s->dircap * 2 : 8;
+            Chunk **tmp = (Chunk**)realloc(s->chunks, newcap * sizeof *tmp);
+            if (!tmp) return VL_ENOMEM;
+            s->chunks = tmp;
+            s->dircap = newcap;
+        }
+        Chunk *c = chunk_new(s);
+        if (!c) return VL_ENOMEM;
+        s->chunks[s->nchunks++] = c;
+    }
+    return 1;
+}
+
+/* ----- Name index ----- */
+
+static size_t hash_name(const char *s) {
+    size_t h = 1469598103934665603ull; /* FNV-1a */
+    for (; *s; ++s) { h ^= (unsigned char)*s; h *= 1099511628211ull; }
+    return h;
+}
+
+/* Probe for name; returns the slot holding it or the empty slot to fill. */
+static size_t probe(const VecStore *s, const char *name) {
+    size_t mask = s->index->cap - 1;
+    size_t h = hash_name(name) & mask;
+    while (s->index->slots[h] && strcmp(slot(s, s->index->slots[h] - 1)->name, name) != 0)
+        h = (h + 1) & mask;
+    return h;
+}
+
+static void index_release(VecStore *s) {
+    if (s->index && --s->index->refs == 0) {
+        free(s->index->slots);
+        free(s->index);
+    }
+    s->index = NULL;
+}
+
+static NameIndex *index_new(size_t cap) {
+    NameIndex *ix = (NameIndex*)malloc(sizeof *ix);
+    if (!ix) return NULL;
+    ix->slots = (size_t*)calloc(cap, sizeof *ix->slots);
+    if (!ix->slots) { free(ix); return NULL; }
+    ix->cap = cap;
+    ix->refs = 1;
+    return ix;
+}
+
+/* Refill a private index from the store, in place. */
+static void index_refill(VecStore *s) {
+    if (!s->index) return;
+    memset(s->index->slots, 0, s->index->cap * sizeof *s->index->slots);
+    for (size_t i = 0; i < s->size; ++i)
+        if (slot(s, i)->used) s->index->slots[probe(s, slot(s, i)->name)] = i + 1;
+}
+
+/* Fresh, unshared index of cap slots filled from the store (cap 0 = none).
+ * The old index is kept if the new one cannot be allocated. */
+static int index_rebuild(VecStore *s, size_t cap) {
+    NameIndex *ix = cap ? index_new(cap) : NULL;
+    if (cap && !ix) return VL_ENOMEM;
+    index_release(s);
+    s->index = ix;
+    index_refill(s);
+    return 1;
+}
+
+/* Make room for `need` names; rehashes at most once per call. */
+static int index_reserve(VecStore *s, size_t need) {
+    size_t cap = s->index ? s->index->cap : 0;
+    if (need * 2 <= cap) return 1;
+    size_t newcap = cap ? cap : 16;
+    while (newcap < need * 2) newcap *= 2;
+    return index_rebuild(s, newcap);
+}
+
+/* Private copy of a shared index, taken before the first new name goes in. */
+static int index_unshare(VecStore *s) {
+    if (!s->index || s->index->refs == 1) return 1;
+    NameIndex *ix = (NameIndex*)malloc(sizeof *ix);
+    size_t *slots = (size_t*)malloc(s->index->cap * sizeof *slots);
+    if (!ix || !slots) { free(ix); free(slots); return VL_ENOMEM; }
+    memcpy(slots, s->index->slots, s->index->cap * sizeof *slots);
+    ix->slots = slots;
+    ix->cap = s->index->cap;
+    ix->refs = 1;
+    s->index->refs--;
+    s->index = ix;
+    return 1;
+}
+
+/* Everything a reordering write needs, taken before anything moves. */
+static int make_private(VecStore *s, size_t first) {
+    if (unshare_from(s, first) < 0 || index_unshare(s) < 0) return VL_ENOMEM;
+    return 1;
+}
+
+/* ----- Store lifetime ----- */
+
+static void store_init(VecStore *s, vl_store *db) {
+    memset(s, 0, sizeof *s);
+    s->db = db;
+    s->shift = db->policy_shift;
+    s->epoch = next_epoch(s);
+}
+
+static void store_release(VecStore *s) {
+    for (size_t c = 0; c < s->nchunks; ++c) chunk_release(s->chunks[c]);
+    free(s->chunks);
+    index_release(s);
+    store_init(s, s->db);
+}
+
+/* O(chunks) snapshot: dst shares every chunk and the index with src.
+ * dst is untouched if the directory cannot be allocated. */
+static int store_share(VecStore *dst, const VecStore *src) {
+    Chunk **dir = (Chunk**)malloc((src->nchunks ? src->nchunks : 1) * sizeof *dir);
+    if (!dir) return VL_ENOMEM;
+    *dst = *src;
+    dst->dircap = src->nchunks;
+    dst->chunks = dir;
+    for (size_t c = 0; c < src->nchunks; ++c) {
+        dst->chunks[c] = src->chunks[c];
+        dst->chunks[c]->refs++;
+    }
+    if (dst->index) dst->index->refs++;
+    return 1;
+}
+
+/* NULL when memory runs out. */
+static Workspace *ws_new(vl_store *db, const char *name) {
+    if (db->nws == db->capws) {
+        size_t newcap = db->capws ? db->capws * 2 : 4;
+        Workspace **tmp = (Workspace**)realloc(db->ws, newcap * sizeof *tmp);
+        if (!tmp) return NULL;
+        db->ws = tmp;
+        db->capws = newcap;
+    }
+    Workspace *w = (Workspace*)calloc(1, sizeof *w);
+    if (!w) return NULL;
+    strncpy(w->name, name, NAME_LEN - 1);
+    store_init(&w->store, db);
+    db->ws[db->nws++] = w;
+    return w;
+}
+
+static void ws_free(Workspace *w) {
+    for (size_t k = 0; k < w->ncps; ++k) store_release(&w->cps[k].snap);
+    free(w->cps);
+    store_release(&w->store);
+    free(w);
+}
+
+vl_store *vl_open(void) {
+    vl_store *db = (vl_store*)calloc(1, sizeof *db);
+    if (!db) return NULL;
+    db->policy_shift = DEFAULT_CHUNK_SHIFT;
+    db->policy_huge = VL_HUGE_OFF;
+    db->cur = ws_new(db, "main");
+    if (!db->cur) { free(db->ws); free(db); return NULL; }
+    return db;
+}
+
+vl_store *vl_open_like(const vl_store *db) {
+    vl_store *s = vl_open();
+    if (!s) return NULL;
+    s->policy_shift = db->policy_shift;
+    s->policy_huge = db->policy_huge;
+    CUR(s)->shift = s->policy_shift;       /* still empty */
+    return s;
+}
+
+void vl_swap(vl_store *a, vl_store *b) {
+    VecStore t = *CUR(a);
+    *CUR(a) = *CUR(b);
+    *CUR(b) = t;
+    CUR(a)->db = a;
+    CUR(b)->db = b;
+    CUR(a)->epoch = next_epoch(CUR(a));
+    CUR(b)->epoch = next_epoch(CUR(b));
+}
+
+void vl_close(vl_store *db) {
+    if (!db) return;
+    for (size_t i = 0; i < db->nws; ++i) ws_free(db->ws[i]);
+    free(db->ws);
+    free(db);
+}
+
+void vl_clear(vl_store *db) {
+    VecStore *g = CUR(db);
+    /* Reset to empty but keep capacity to avoid churn (see vl_shrink).
+     * Chunks still shared with a checkpoint are let go instead of kept. */
+    size_t kept = 0;
+    for (size_t c = 0; c < g->nchunks; ++c) {
+        if (g->chunks[c]->refs > 1) chunk_release(g->chunks[c]);
+        else g->chunks[kept++] = g->chunks[c];
+    }
+    g->nchunks = kept;
+    g->size = 0;
+    g->epoch = next_epoch(g);
+    if (g->index && index_unshare(g) < 0) index_release(g);   /* rebuilt on next insert */
+    else if (g->index) memset(g->index->slots, 0, g->index->cap * sizeof *g->index->slots);
+}
+
+/* ----- Lookup / insert ----- */
+
+/* Slot holding name, or -1. */
+static long find_index(const VecStore *s, const char *name) {
+    if (!s->index) return -1;
+    size_t slot = s->index->slots[probe(s, name)];
+    if (!slot) return -1;
+    return slot - 1;
+}
+
+/* Insert or update one row. Capacity must already be reserved.
+ * Returns 1 if a new name was added, 0 if an existing one was hit,
+ * VL_ENOMEM (store unchanged) if a shared chunk or index could not be copied. */
+static int put_row(VecStore *s, const char *name, const double v[3], int keep_last) {
+    size_t h = probe(s, name);
+    if (s->index->slots[h]) {
+        if (keep_last) {
+            Vec *e = slot_mut(s, s->index->slots[h] - 1);
+            if (!e) return VL_ENOMEM;
+            e->v[0] = v[0]; e->v[1] = v[1]; e->v[2] = v[2];
+        }
+        return 0;
+    }
+    if (index_unshare(s) < 0) return VL_ENOMEM;
+    Vec *e = slot_mut(s, s->size);
+    if (!e) return VL_ENOMEM;
+    e->used = 1;
+    strncpy(e->name, name, NAME_LEN - 1);
+    e->name[NAME_LEN - 1] = '\0';
+    e->v[0] = v[0]; e->v[1] = v[1]; e->v[2] = v[2];
+    s->index->slots[h] = ++s->size;
+    return 1;
+}
+
+int vl_set(vl_store *db, const char *name, const double v[3]) {
+    VecStore *g = CUR(db);
+    if (vl_reserve(db, 1) < 0 || put_row(g, name, v, 1) < 0) return VL_ENOMEM;
+    return 1;
+}
+
+size_t vl_append(vl_store *db, const Vec *rows, size_t n, int keep_last) {
+    VecStore *g = CUR(db);
+    if (vl_reserve(db, n) < 0) return VL_ERROR;
+    size_t added = 0;
+    for (size_t i = 0; i < n; ++i) {
+        int r = put_row(g, rows[i].name, rows[i].v, keep_last);
+        if (r < 0) return VL_ERROR;
+        added += (size_t)r;
+    }
+    return added;
+}
+
+int vl_reserve(vl_store *db, size_t n) {
+    VecStore *g = CUR(db);
+    if (ensure_capacity(g, g->size + n) < 0 || index_reserve(g, g->size + n) < 0) return VL_ENOMEM;
+    return 1;
+}
+
+int vl_get(const vl_store *db, const char *name, double out[3]) {
+    const VecStore *g = CUR(db);
+    long idx = find_index(g, name);
+    if (idx < 0) return db->fallback ? db->fallback(db->fallback_ctx, name, out) : 0;
+    const Vec *e = slot(g, (size_t)idx);
+    out[0] = e->v[0];
+    out[1] = e->v[1];
+    out[2] = e->v[2];
+    return 1;
+}
+
+long vl_find(const vl_store *db, const char *name) {
+    return find_index(CUR(db), name);
+}
+
+/* |v| of slot i, computed once and cached until the slot is written. */
+double vl_slot_mag(vl_store *db, size_t i) {
+    VecStore *g = CUR(db);
+    double *c = mag_slot(g, i);
+    if (isnan(*c)) *c = v_mag(slot(g, i)->v);
+    return *c;
+}
+
+/* Cached magnitude of every slot; missing ones are filled in batches. */
+void vl_mags(vl_store *db, double *out) {
+    enum { BATCH = 256 };
+    VecStore *g = CUR(db);
+    double v[BATCH][3], m[BATCH];
+    size_t idx[BATCH], n = 0;
+    for (size_t i = 0; i <= g->size; ++i) {
+        if (i < g->size) {
+            double c = *mag_slot(g, i);
+            if (!isnan(c)) { out[i] = c; continue; }
+            memcpy(v[n], slot(g, i)->v, sizeof v[n]);
+            idx[n++] = i;
+        }
+        if (n == BATCH || (i == g->size && n)) {
+            v_mag_batch((const double (*)[3])v, m, n);
+            for (size_t k = 0; k < n; ++k) out[idx[k]] = *mag_slot(g, idx[k]) = m[k];
+            n = 0;
+        }
+    }
+}
+
+int vl_mag(vl_store *db, const char *name, double *out) {
+    long idx = find_index(CUR(db), name);
+    if (idx >= 0) { *out = vl_slot_mag(db, (size_t)idx); return 1; }
+    double v[3];
+    if (!db->fallback || !db->fallback(db->fallback_ctx, name, v)) return 0;
+    *out = v_mag(v);
+    return 1;
+}
+
+void vl_list(const vl_store *db) {
+    const VecStore *g = CUR(db);
+    int any = 0;
+    for (size_t i = 0; i < g->size; ++i) {
+        if (slot(g, i)->used) {
+            vl_print_vec(slot(g, i)->name, slot(g, i)->v);
+            any = 1;
+        }
+    }
+    if (!any) puts("(no vectors stored)");
+}
+
+void vl_set_fallback(vl_store *db, vl_fallback_fn fn, void *ctx) {
+    db->fallback = fn;
+    db->fallback_ctx = ctx;
+}
+
+/* ----- Raw access (for query/sort modules) ----- */
+
+size_t vl_size(const vl_store *db) { return CUR(db)->size; }
+
+const Vec *vl_at(const vl_store *db, size_t i) {
+    return i < CUR(db)->size ? slot(CUR(db), i) : NULL;
+}
+
+int vl_permute(vl_store *db, const size_t *order) {
+    VecStore *g = CUR(db);
+    if (!g->size) return 1;
+    Vec *tmp = (Vec*)malloc(g->size * sizeof *tmp);
+    double *mag = (double*)malloc(g->size * sizeof *mag);
+    if (!tmp || !mag || make_private(g, 0) < 0) {
+        free(tmp);
+        free(mag);
+        return VL_ENOMEM;
+    }
+    for (size_t k = 0; k < g->size; ++k) {
+        tmp[k] = *slot(g, order[k]);
+        mag[k] = *mag_slot(g, order[k]);
+    }
+    for (size_t k = 0; k < g->size; ++k) {
+        *slot_mut(g, k) = tmp[k];
+        *mag_slot(g, k) = mag[k];       /* cached magnitudes move with their vectors */
+    }
+    free(tmp);
+    free(mag);
+    g->epoch = next_epoch(g);
+    index_refill(g);
+    return 1;
+}
+
+unsigned long vl_epoch(const vl_store *db) { return CUR(db)->epoch; }
+
+int vl_set_at(vl_store *db, size_t i, const double v[3]) {
+    VecStore *g = CUR(db);
+    if (i >= g->size) return 0;
+    Vec *e = slot_mut(g, i);
+    if (!e) return VL_ENOMEM;
+    e->v[0] = v[0]; e->v[1] = v[1]; e->v[2] = v[2];
+    return 1;
+}
+
+size_t vl_delete(vl_store *db, const uint64_t *bits, size_t nbits) {
+    VecStore *g = CUR(db);
+    size_t first = 0;   /* slots before the first deletion do not move */
+    while (first < g->size && !(first < nbits && ((bits[first >> 6] >> (first & 63)) & 1)) &&
+           slot(g, first)->used)
+        first++;
+    if (first == g->size) return 0;
+    if (make_private(g, first) < 0) return VL_ERROR;
+    size_t j = first;
+    for (size_t i = first; i < g->size; ++i) {
+        int gone = i < nbits && ((bits[i >> 6] >> (i & 63)) & 1);
+        if (gone || !slot(g, i)->used) continue;
+        if (j != i) {
+            double m = *mag_slot(g, i);
+            *slot_mut(g, j) = *slot(g, i);
+            *mag_slot(g, j) = m;
+        }
+        j++;
+    }
+    size_t removed = g->size - j;
+    g->size = j;
+    if (removed) {
+        g->epoch = next_epoch(g);
+        index_refill(g);
+    }
+    return removed;
+}
+
+int vl_del(vl_store *db, const char *name) {
+    long idx = find_index(CUR(db), name);
+    if (idx < 0) return 0;
+    uint64_t *bits = (uint64_t*)calloc((size_t)idx / 64 + 1, sizeof *bits);
+    if (!bits) return VL_ENOMEM;
+    bits[idx >> 6] = 1ull << (idx & 63);
+    size_t removed = vl_delete(db, bits, (size_t)idx + 1);
+    free(bits);
+    return removed == VL_ERROR ? VL_ENOMEM : 1;
+}
+
+/* ----- Workspaces and checkpoints ----- */
+
+static Workspace *find_ws(const vl_store *db, const char *name) {
+    for (size_t i = 0; i < db->nws; ++i)
+        if (strcmp(db->ws[i]->name, name) == 0) return db->ws[i];
+    return NULL;
+}
+
+static Checkpoint *find_cp(Workspace *w, const char *tag) {
+    for (size_t k = 0; k < w->ncps; ++k)
+        if (strcmp(w->cps[k].tag, tag) == 0) return &w->cps[k];
+    return NULL;
+}
+
+int vl_ws_create(vl_store *db, const char *name, int fork) {
+    if (find_ws(db, name)) return 0;
+    Workspace *w = ws_new(db, name);
+    if (!w) return VL_ENOMEM;
+    if (fork) {
+        if (store_share(&w->store, CUR(db)) < 0) {
+            db->nws--;          /* ws_new appended it; nothing shared yet */
+            ws_free(w);
+            return VL_ENOMEM;
+        }
+        w->store.epoch = next_epoch(&w->store);
+    }
+    return 1;
+}
+
+int vl_ws_use(vl_store *db, const char *name) {
+    Workspace *w = find_ws(db, name);
+    if (!w) return 0;
+    db->cur = w;
+    return 1;
+}
+
+int vl_ws_drop(vl_store *db, const char *name) {
+    Workspace *w = find_ws(db, name);
+    if (!w || w == db->cur) return 0;
+    for (size_t i = 0; i < db->nws; ++i)
+        if (db->ws[i] == w) { db->ws[i] = db->ws[--db->nws]; break; }
+    ws_free(w);
+    return 1;
+}
+
+void vl_ws_list(const vl_store *db) {
+    for (size_t i = 0; i < db->nws; ++i) {
+        const Workspace *w = db->ws[i];
+        printf("%c %-16s %zu vectors", w == db->cur ? '*' : ' ', w->name, w->store.size);
+        if (w->ncps) {
+            printf("  checkpoints:");
+            for (size_t k = 0; k < w->ncps; ++k) printf(" %s", w->cps[k].tag);
+        }
+        putchar('\n');
+    }
+}
+
+const char *vl_ws_current(const vl_store *db) { return db->cur->name; }
+
+int vl_checkpoint_create(vl_store *db, const char *tag) {
+    Workspace *cur = db->cur;
+    VecStore snap;
+    if (store_share(&snap, CUR(db)) < 0) return VL_ENOMEM;
+    Checkpoint *cp = find_cp(cur, tag);
+    if (cp) store_release(&cp->snap);       /* re-tag: replace */
+    else {
+        if (cur->ncps == cur->capcps) {
+            size_t newcap = cur->capcps ? cur->capcps * 2 : 4;
+            Checkpoint *tmp = (Checkpoint*)realloc(cur->cps, newcap * sizeof *tmp);
+            if (!tmp) { store_release(&snap); return VL_ENOMEM; }
+            cur->cps = tmp;
+            cur->capcps = newcap;
+        }
+        cp = &cur->cps[cur->ncps++];
+        memset(cp->tag, 0, sizeof cp->tag);
+        strncpy(cp->tag, tag, NAME_LEN - 1);
+    }
+    cp->snap = snap;
+    return 1;
+}
+
+int vl_checkpoint_rollback(vl_store *db, const char *tag) {
+    Checkpoint *cp = find_cp(db->cur, tag);
+    if (!cp) return 0;
+    VecStore *g = CUR(db), back;
+    if (store_share(&back, &cp->snap) < 0) return VL_ENOMEM;
+    store_release(g);
+    *g = back;
+    g->epoch = next_epoch(g);
+    return 1;
+}
+
+int vl_checkpoint_drop(vl_store *db, const char *tag) {
+    Workspace *cur = db->cur;
+    Checkpoint *cp = find_cp(cur, tag);
+    if (!cp) return 0;
+    store_release(&cp->snap);
+    *cp = cur->cps[--cur->ncps];
+    return 1;
+}
+
+/* ----- Memory policy ----- */
+
+/* Move every vector into chunks of the current policy size. The new
+ * chunks are filled before the old ones go, so a failure changes nothing. */
+static int relayout(VecStore *s) {
+    VecStore fresh = *s;
+    fresh.chunks = NULL;
+    fresh.nchunks = fresh.dircap = 0;
+    fresh.shift = s->db->policy_shift;
+    if (ensure_capacity(&fresh, s->size) < 0) {
+        for (size_t c = 0; c < fresh.nchunks; ++c) chunk_release(fresh.chunks[c]);
+        free(fresh.chunks);
+        return VL_ENOMEM;
+    }
+    for (size_t i = 0; i < s->size; ++i) {
+        *slot_mut(&fresh, i) = *slot(s, i);          /* fresh chunks are private */
+        *mag_slot(&fresh, i) = *mag_slot(s, i);
+    }
+    for (size_t c = 0; c < s->nchunks; ++c) chunk_release(s->chunks[c]);
+    free(s->chunks);
+    s->chunks = fresh.chunks;
+    s->nchunks = fresh.nchunks;
+    s->dircap = fresh.dircap;
+    s->shift = fresh.shift;
+    return 1;
+}
+
+static size_t footprint(const VecStore *s) {
+    size_t b = s->dircap * sizeof *s->chunks;
+    for (size_t c = 0; c < s->nchunks; ++c) b += s->chunks[c]->mem.bytes + (sizeof(double) << s->shift);
+    if (s->index) b += s->index->cap * sizeof *s->index->slots;
+    return b;
+}
+
+size_t vl_shrink(vl_store *db) {
+    VecStore *g = CUR(db);
+    size_t before = footprint(g);
+
+    if (g->shift != db->policy_shift) relayout(g);   /* best effort: kept as is if it fails */
+
+    /* Drop chunks past the last used slot, then trim the directory. */
+    size_t keep = (g->size + ((size_t)1 << g->shift) - 1) >> g->shift;
+    while (g->nchunks > keep) chunk_release(g->chunks[--g->nchunks]);
+    if (!g->nchunks) { free(g->chunks); g->chunks = NULL; g->dircap = 0; }
+    else if (g->dircap > g->nchunks) {
+        Chunk **tmp = (Chunk**)realloc(g->chunks, g->nchunks * sizeof *tmp);
+        if (tmp) { g->chunks = tmp; g->dircap = g->nchunks; }
+    }
+
+    size_t cap = 0;
+    if (g->size) { cap = 16; while (cap < g->size * 2) cap *= 2; }
+    if (cap != (g->index ? g->index->cap : 0)) index_rebuild(g, cap);   /* likewise */
+
+    size_t after = footprint(g);
+    return before > after ? before - after : 0;
+}
+
+int vl_set_chunk(vl_store *db, size_t vecs) {
+    VecStore *g = CUR(db);
+    unsigned shift = 0;
+    while (((size_t)1 << shift) < vecs && shift < MAX_CHUNK_SHIFT) shift++;
+    if (!vecs || ((size_t)1 << shift) < vecs) return 0;
+    if (g->shift != shift) {
+        unsigned old = db->policy_shift;
+        db->policy_shift = shift;
+        if (!g->nchunks) g->shift = shift;
+        else if (relayout(g) < 0) { db->policy_shift = old; return VL_ENOMEM; }
+    }
+    db->policy_shift = shift;
+    return 1;
+}
+
+void vl_set_huge(vl_store *db, int mode) { db->policy_huge = mode; }
+
+static void print_bytes(size_t b) {
+    if (b >= ((size_t)1 << 30))      printf("%.2f GiB", (double)b / (double)((size_t)1 << 30));
+    else if (b >= ((size_t)1 << 20)) printf("%.2f MiB", (double)b / (double)((size_t)1 << 20));
+    else if (b >= 1024)              printf("%.1f KiB", (double)b / 1024.0);
+    else                             printf("%zu B", b);
+}
+
+void vl_mem_report(const vl_store *db) {
+    const VecStore *g = CUR(db);
+    size_t cap = capacity(g), chunk_vecs = (size_t)1 << g->shift, reserved = 0, shared = 0;
+    size_t kinds[MEM_KINDS] = {0};
+    for (size_t c = 0; c < g->nchunks; ++c) {
+        reserved += g->chunks[c]->mem.bytes;
+        kinds[g->chunks[c]->mem.kind]++;
+        shared += g->chunks[c]->refs > 1;
+    }
+    size_t index_cap = g->index ? g->index->cap : 0;
+
+    printf("workspace   : %s\n", db->cur->name);
+    printf("vectors     : %zu used / %zu capacity", g->size, cap);
+    if (cap) printf(" (%.1f%%)", 100.0 * (double)g->size / (double)cap);
+    printf("\nchunks      : %zu x %zu vectors (", g->nchunks, chunk_vecs);
+    print_bytes(sizeof(Vec) * chunk_vecs);
+    printf(" each)");
+    for (int k = 0; k < MEM_KINDS; ++k) if (kinds[k]) printf(", %zu %s", kinds[k], mem_kind_name(k));
+    if (shared) printf(", %zu shared (copy-on-write)", shared);
+    printf("\nvector data : ");
+    print_bytes(reserved);
+    printf(" reserved, ");
+    print_bytes(g->size * sizeof(Vec));
+    printf(" in use\nmag cache   : ");
+    print_bytes(g->nchunks * (sizeof(double) << g->shift));
+    printf("\nname index  : %zu slots (", index_cap);
+    print_bytes(index_cap * sizeof(size_t));
+    printf(")%s", g->index && g->index->refs > 1 ? ", shared" : "");
+    printf("\npolicy      : new chunks of %zu vectors, huge pages %s",
+           (size_t)1 << db->policy_shift, huge_mode_name(db->policy_huge));
+    if (db->policy_huge != VL_HUGE_OFF && sizeof(Vec) * ((size_t)1 << db->policy_shift) < HUGE_PAGE_SIZE)
+        printf(" (needs chunks >= %zu vectors)", (size_t)HUGE_PAGE_SIZE / sizeof(Vec));
+    putchar('\n');
+}
+
+/* ----- Vector math ----- */
+
+void v_add(const double a[3], const double b[3], double r[3]) {
+    r[0] = a[0] + b[0]; r[1] = a[1] + b[1]; r[2] = a[2] + b[2];
+}
+
+void v_sub(const double a[3], const double b[3], double r[3]) {
+    r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2];
+}
+
+void v_scale(const double a[3], double s, double r[3]) {
+    r[0] = a[0] * s; r[1] = a[1] * s; r[2] = a[2] * s;
+}
+
+double v_dot(const double a[3], const double b[3]) {
+    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+}
+
+void v_cross(const double a[3], const double b[3], double r[3]) {
+    r[0] = a[1]*b[2] - a[2]*b[1];
+    r[1] = a[2]*b[0] - a[0]*b[2];
+    r[2] = a[0]*b[1] - a[1]*b[0];
+}
+
+double v_mag(const double a[3]) {
+    return sqrt(v_dot(a, a));
+}
+
+int v_normalize(const double a[3], double r[3]) {
+    double m = v_mag(a);
+    if (m == 0.0) { r[0] = r[1] = r[2] = 0.0; return 0; }
+    v_scale(a, 1.0 / m, r);
+    return 1;
+}
+
+double v_angle(const double a[3], const double b[3]) {
+    double m = v_mag(a) * v_mag(b);
+    if (m == 0.0) return NAN;
+    double c = v_dot(a, b) / m;
+    return acos(c > 1.0 ? 1.0 : c < -1.0 ? -1.0 : c);   /* rounding can overshoot */
+}
+
+int v_project(const double a[3], const double b[3], double r[3]) {
+    double bb = v_dot(b, b);
+    if (bb == 0.0) { r[0] = r[1] = r[2] = 0.0; return 0; }
+    v_scale(b, v_dot(a, b) / bb, r);
+    return 1;
+}
+
+/* The batch kernels live in vector_kernels.inc, one build per instruction
+ * set; vk holds the ones chosen for this CPU (vector_cpu.c). */
+
+void v_sub_batch(const double (*a)[3], const double (*b)[3], double (*r)[3], size_t n) {
+    vk.sub(a[0], b[0], r[0], 3 * n);
+}
+
+void v_cross_batch(const double (*a)[3], const double (*b)[3], double (*r)[3], size_t n) {
+    vk.cross(a, b, r, n);
+}
+
+void v_rsqrt_batch(const double *x, double *out, size_t n) {
+    vk.rsqrt(x, out, n);
+}
+
+void v_mag_batch(const double (*a)[3], double *out, size_t n) {
+    vk.norm2(a, out, n);
+    double r[256];
+    for (size_t i = 0; i < n; i += 256) {
+        size_t m = n - i < 256 ? n - i : 256;
+        vk.rsqrt(out + i, r, m);
+        for (size_t k = 0; k < m; ++k) {
+            double sq = out[i + k];
+            out[i + k] = sq > 0.0 && sq < INFINITY ? sq * r[k] : sqrt(sq);
+        }
+    }
+}
+
+void v_normalize_batch(const double (*a)[3], double (*r)[3], size_t n) {
+    double sq[256], inv[256];
+    for (size_t i = 0; i < n; i += 256) {
+        size_t m = n - i < 256 ? n - i : 256;
+        vk.norm2(a + i, sq, m);
+        vk.rsqrt(sq, inv, m);
+        for (size_t k = 0; k < m; ++k) {
+            if (sq[k] > 0.0 && sq[k] < INFINITY) v_scale(a[i + k], inv[k], r[i + k]);
+            else v_normalize(a[i + k], r[i + k]);
+        }
+    }
+}
+
+const char *vl_kernels(void) {
+    return vk.name;
+}
+
+/* ----- Display ----- */
+
+void vl_print_vec(const char *name, const double v[3]) {
+    printf("%s = %.3f   %.3f   %.3f\n", name, v[0], v[1], v[2]);
+}
+
+/* ----- CSV ----- */
+
+static void trim_right(char *s) {
+    size_t n = strlen(s);
+    while (n && (unsigned char)s[n-1] <= ' ') s[--n] = '\0';
+}
+
+/* Guess the row count from the file size and the line length of its first block. */
+static size_t estimate_rows(FILE *fp) {
+    if (fseek(fp, 0, SEEK_END) != 0) return 0;
+    long size = ftell(fp);
+    rewind(fp);
+    if (size <= 0) return 0;
+
+    char buf[65536];
+    size_t n = fread(buf, 1, sizeof buf, fp), lines = 0;
+    rewind(fp);
+    for (size_t i = 0; i < n; ++i) lines += buf[i] == '\n';
+    if (!lines) return 1;
+    return (size_t)((double)size * (double)lines / (double)n) + 1;
+}
+
+/* Read name,x,y,z rows into the store in one pass: capacity and index are
+ * reserved once up front, then each row is a single hash probe. Out of
+ * memory stops the load; the rows read before that stay, and *st counts them. */
+int vl_load_csv(vl_store *db, const char *fname, int clear_first, int keep_last, vl_csv_stats *st) {
+    FILE *fp = fopen(fname, "r");
+    if (!fp) return 0;
+    if (clear_first) vl_clear(db);
+
+    VecStore *g = CUR(db);
+    size_t had = g->nchunks;
+    if (vl_reserve(db, estimate_rows(fp)) < 0)      /* only a hint: give back what it got */
+        while (g->nchunks > had) chunk_release(g->chunks[--g->nchunks]);
+
+    char line[256];
+    char name[NAME_LEN];
+    double v[3];
+    vl_csv_stats local = {0, 0, 0};
+    int rc = 1;
+
+    while (fgets(line, sizeof line, fp)) {
+        trim_right(line);
+        if (!*line) continue;
+        if (sscanf(line, "%31[^,],%lf,%lf,%lf", name, &v[0], &v[1], &v[2]) == 4) {
+            int r = vl_reserve(db, 1) < 0 ? VL_ENOMEM : put_row(g, name, v, keep_last);
+            if (r < 0) { rc = VL_ENOMEM; break; }
+            local.added += (size_t)r;
+            local.rows++;
+        } else {
+            local.bad++;
+        }
+    }
+
+    fclose(fp);
+    if (st) *st = local;
+    return rc;
+}
+
+int vl_save_csv(const vl_store *db, const char *fname, const size_t *rows, size_t n) {
+    const VecStore *g = CUR(db);
+    FILE *fp = fopen(fname, "w");
+    if (!fp) return 0;
+    for (size_t k = 0; k < n; ++k) {
+        size_t i = rows ? rows[k] : k;
+        if (i < g->size && slot(g, i)->used) {
+            const Vec *e = slot(g, i);
+            fprintf(fp, "%s,%.6f,%.6f,%.6f\n", e->name, e->v[0], e->v[1], e->v[2]);
+        }
+    }
+    fclose(fp);
+    return 1;
+}
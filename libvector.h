@@ -0,0 +1,150 @@
+/* Filename: libvector.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Embeddable vector store and math (libvector.a / libvector.so).
+ *              All state hangs off an opaque vl_store handle, so a process can
+ *              keep any number of independent stores. Calls on different
+ *              handles never touch shared state; one handle is used by one
+ *              thread at a time (lock around it if you share it).
+ */
+#ifndef LIBVECTOR_H
+#define LIBVECTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The library is built with -fvisibility=hidden; only what this header
+ * declares is exported from libvector.so. */
+#if defined(__GNUC__)
+#pragma GCC visibility push(default)
+#endif
+
+#define NAME_LEN 32
+
+typedef struct {
+    int used;
+    char name[NAME_LEN];
+    double v[3];
+} Vec;
+
+typedef struct vl_store vl_store;
+
+/* Errors. The library never exits. Calls returning int give 1 on success,
+ * 0 for an unknown name or tag (or a file that cannot be opened) and
+ * VL_ENOMEM when memory runs out; the store is then as it was before the
+ * call unless noted. Calls returning a count give VL_ERROR instead, and
+ * vl_open/vl_open_like give NULL. */
+enum { VL_ENOMEM = -1 };
+#define VL_ERROR ((size_t)-1)
+
+/* Lifetime. A new store has one empty workspace, "main". */
+vl_store *vl_open(void);
+void      vl_close(vl_store *db);
+
+/* Loading off to the side: fill an empty store from vl_open_like (same chunk
+ * and huge-page policy), then vl_swap exchanges the vectors of the two current
+ * workspaces in O(1). Checkpoints stay with their workspace. */
+vl_store *vl_open_like(const vl_store *db);
+void      vl_swap(vl_store *a, vl_store *b);
+
+/* Vectors by name (current workspace) */
+int    vl_set(vl_store *db, const char *name, const double v[3]);
+int    vl_get(const vl_store *db, const char *name, double out[3]);
+long   vl_find(const vl_store *db, const char *name);       // slot, or -1
+int    vl_mag(vl_store *db, const char *name, double *out); // cached |v|
+int    vl_del(vl_store *db, const char *name);
+void   vl_clear(vl_store *db);                              // keeps capacity
+void   vl_list(const vl_store *db);                         // prints to stdout
+
+/* Consulted by vl_get/vl_mag when a name is not in the store; ctx is passed
+ * back unchanged, so one callback can serve several handles. NULL fn = none. */
+typedef int (*vl_fallback_fn)(void *ctx, const char *name, double out[3]);
+void   vl_set_fallback(vl_store *db, vl_fallback_fn fn, void *ctx);
+
+/* Bulk insert: reserves room for n rows once, then one hash probe per row.
+ * keep_last = 1 lets later rows overwrite. Returns the number of new names,
+ * or VL_ERROR with the rows before the failing one already in. */
+size_t vl_append(vl_store *db, const Vec *rows, size_t n, int keep_last);
+
+/* Room for n more names up front (e.g. before a series of vl_append). */
+int    vl_reserve(vl_store *db, size_t n);
+
+/* Raw slot access, 0 .. vl_size()-1 */
+size_t        vl_size(const vl_store *db);
+const Vec    *vl_at(const vl_store *db, size_t i);
+int           vl_permute(vl_store *db, const size_t *order); // slot k <- old slot order[k]
+int           vl_set_at(vl_store *db, size_t i, const double v[3]); // 0 if i is out of range
+size_t        vl_delete(vl_store *db, const uint64_t *bits, size_t nbits); // compacts
+unsigned long vl_epoch(const vl_store *db); // changes when slots move or vanish
+
+/* Magnitudes are cached per slot and dropped whenever the slot is written;
+ * moves (permute, delete) keep them. */
+double vl_slot_mag(vl_store *db, size_t i);
+void   vl_mags(vl_store *db, double *out); // vl_size() values
+
+/* Memory: vectors live in fixed-size chunks, so growth never copies them.
+ * Chunks of at least 2 MiB can use huge pages: VL_HUGE_THP asks for
+ * transparent ones, VL_HUGE_ON for explicit ones (falling back to THP). */
+enum { VL_HUGE_OFF, VL_HUGE_THP, VL_HUGE_ON };
+
+size_t vl_shrink(vl_store *db);                // returns bytes released (best effort)
+int    vl_set_chunk(vl_store *db, size_t vecs); // rounded up to a power of two
+void   vl_set_huge(vl_store *db, int mode);     // VL_HUGE_OFF / VL_HUGE_THP / VL_HUGE_ON
+void   vl_mem_report(const vl_store *db);
+
+/* Workspaces and copy-on-write checkpoints. All return 0 when the name is
+ * unknown (or, for create, already taken; for drop, in use). */
+int         vl_ws_create(vl_store *db, const char *name, int fork);
+int         vl_ws_use(vl_store *db, const char *name);
+int         vl_ws_drop(vl_store *db, const char *name);
+void        vl_ws_list(const vl_store *db);
+const char *vl_ws_current(const vl_store *db);
+int         vl_checkpoint_create(vl_store *db, const char *tag);
+int         vl_checkpoint_rollback(vl_store *db, const char *tag);
+int         vl_checkpoint_drop(vl_store *db, const char *tag);
+
+/* CSV (name,x,y,z). Returns 0 if the file cannot be opened. Counts go to
+ * the optional out-parameters; malformed lines are skipped and counted.
+ * On VL_ENOMEM the load stops and the rows read so far stay. */
+typedef struct {
+    size_t rows, added, bad;
+} vl_csv_stats;
+
+int vl_load_csv(vl_store *db, const char *fname, int clear_first, int keep_last, vl_csv_stats *st);
+int vl_save_csv(const vl_store *db, const char *fname, const size_t *rows, size_t n); // rows NULL = slots 0..n-1
+
+/* Vector math */
+void   v_add  (const double a[3], const double b[3], double r[3]);
+void   v_sub  (const double a[3], const double b[3], double r[3]);
+void   v_scale(const double a[3], double s,          double r[3]);
+double v_dot  (const double a[3], const double b[3]);
+void   v_cross(const double a[3], const double b[3], double r[3]);
+
+/* Length, direction, angle, projection. The int ones return 0 (and a zero
+ * result) for a zero-length input; v_angle returns NAN then. */
+double v_mag      (const double a[3]);
+int    v_normalize(const double a[3], double r[3]);
+double v_angle    (const double a[3], const double b[3]);              // radians
+int    v_project  (const double a[3], const double b[3], double r[3]); // a onto b
+
+/* Batch forms over packed vectors (r may alias a or b for sub). */
+void v_sub_batch  (const double (*a)[3], const double (*b)[3], double (*r)[3], size_t n);
+void v_cross_batch(const double (*a)[3], const double (*b)[3], double (*r)[3], size_t n);
+
+/* Length batches, built on a vectorized reciprocal sqrt. */
+void v_rsqrt_batch    (const double *x, double *out, size_t n);
+void v_mag_batch      (const double (*a)[3], double *out, size_t n);
+void v_normalize_batch(const double (*a)[3], double (*r)[3], size_t n);
+
+/* Instruction set the batch kernels run on ("scalar", "sse2", "avx2",
+ * "avx512"): the best this CPU supports, or lower if VL_KERNELS says so. */
+const char *vl_kernels(void);
+
+/* Display helper */
+void vl_print_vec(const char *name, const double v[3]);
+
+#if defined(__GNUC__)
+#pragma GCC visibility pop
+#endif
+
+#endif /* LIBVECTOR_H */
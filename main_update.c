@@ -2,51 +2,102 @@
  * Author: Caleb Wilson
  * Date: 10/19/25
  * Description: Lab 7 UI + parsing. Keeps Lab 5 behaviors, adds CSV + dynamic store.
- * To compile: gcc -Wall -Wextra -Wpedantic -O2 -o vectorcalc vector_update.c main_update.c
+ * To compile: gcc -Wall -Wextra -Wpedantic -O2 -pthread -o vectorcalc libvector.c vector_mem.c vector_cpu.c vector_update.c vector_async.c vector_query.c vector_select.c vector_trace.c vector_shm.c vector_particles.c vector_mesh.c main_update.c -lm -lrt
  */
+#define _POSIX_C_SOURCE 200809L   /* fileno, poll */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <math.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/stat.h>
 #include "vector_update.h"
+#include "vector_async.h"
+#include "vector_query.h"
+#include "vector_select.h"
+#include "vector_trace.h"
+#include "vector_shm.h"
+#include "vector_particles.h"
+#include "vector_mesh.h"
 
 #define LINE_LEN 256
 
 /* ---------- tiny string helpers ---------- */
 
-static void trim_right(char *s) {
+/* Cut trailing whitespace in place and return the first non-blank, so
+ * nothing is ever shifted or copied. */
+static char *strip(char *s) {
     size_t n = strlen(s);
     while (n && isspace((unsigned char)s[n-1])) s[--n] = '\0';
+    while (isspace((unsigned char)*s)) s++;
+    return s;
 }
 
-static void trim_left(char *s) {
-    size_t i = 0, n = strlen(s);
-    while (i < n && isspace((unsigned char)s[i])) i++;
-    if (i) memmove(s, s + i, n - i + 1);
-}
-
-static void trim(char *s) { trim_right(s); trim_left(s); }
-
-/* Convert commas to spaces (so "1, 2, 3" works). */
-static void to_spaces(char *s) {
-    for (; *s; ++s) if (*s == ',') *s = ' ';
+static int is_sep(char c) { return c == ' ' || c == '\t' || c == ','; }
+
+/* Decimal to double in one pass. A mantissa below 2^53 times 10^e with
+ * |e| <= 22 is one correctly rounded multiply or divide (both exact
+ * doubles), so the result matches strtod; anything else (long mantissas,
+ * big exponents, hex, inf/nan) goes to strtod. Returns the end of the
+ * number, or NULL if none starts at s. */
+static char *parse_num(char *s, double *out) {
+    static const double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    char *p = s;
+    int neg = 0, digits = 0, exp10 = 0, seen = 0;
+    uint64_t m = 0;
+
+    if (*p == '+' || *p == '-') neg = *p++ == '-';
+    for (; *p >= '0' && *p <= '9'; ++p, seen = 1) {
+        if (digits < 19) { m = m * 10 + (uint64_t)(*p - '0'); digits += m != 0; }
+        else exp10++;
+    }
+    if (*p == '.') {
+        for (++p; *p >= '0' && *p <= '9'; ++p, seen = 1)
+            if (digits < 19) { m = m * 10 + (uint64_t)(*p - '0'); digits += m != 0; exp10--; }
+    }
+    if (!seen) goto slow;
+    if (*p == 'e' || *p == 'E') {
+        char *q = p + 1;
+        int eneg = 0, e = 0;
+        if (*q == '+' || *q == '-') eneg = *q++ == '-';
+        if (*q < '0' || *q > '9') goto slow;
+        for (; *q >= '0' && *q <= '9'; ++q) if (e < 10000) e = e * 10 + (*q - '0');
+        exp10 += eneg ? -e : e;
+        p = q;
+    }
+    if (isalpha((unsigned char)*p) || *p == '.') goto slow;
+    if (m == 0) { *out = neg ? -0.0 : 0.0; return p; }
+    if ((m >> 53) || exp10 < -22 || exp10 > 22) goto slow;
+    *out = exp10 < 0 ? (double)m / pow10[-exp10] : (double)m * pow10[exp10];
+    if (neg) *out = -*out;
+    return p;
+
+slow: {
+        char *end = NULL;
+        *out = strtod(s, &end);
+        return end == s ? NULL : end;
+    }
 }
 
-/* Collapse runs of whitespace to single spaces. */
-static void collapse_ws(const char *in, char *out, size_t outsz) {
-    size_t i = 0, j = 0;
-    int in_space = 1;
-    while (in[i] && j + 1 < outsz) {
-        char c = in[i++];
-        if (isspace((unsigned char)c)) {
-            if (!in_space) { out[j++] = ' '; in_space = 1; }
-        } else {
-            out[j++] = c; in_space = 0;
-        }
+/* Parse "x y z", "x,y,z" or "x y" (z = 0) with nothing after it.
+ * Returns 1 and fills v, or 0 if s is not such a list. */
+static int parse_vec3(char *s, double v[3]) {
+    int n = 0;
+    v[2] = 0.0;
+    for (;;) {
+        while (is_sep(*s)) s++;
+        if (!*s) break;
+        if (n == 3 || !(s = parse_num(s, &v[n]))) return 0;
+        if (*s && !is_sep(*s)) return 0;
+        n++;
     }
-    if (j && out[j-1] == ' ') j--;
-    out[j] = '\0';
+    return n >= 2;
 }
 
 static int is_number(const char *s) {
@@ -73,21 +124,100 @@ static void print_help(void) {
     puts("  a * s   or   s * a     Scalar multiply (s is a number)");
     puts("  dot a b                Dot product (prints scalar)");
     puts("  cross a b              Cross product (prints vector)");
+    puts("  mag a                  Magnitude (cached until a changes)");
+    puts("  norm a                 Unit vector in the direction of a");
+    puts("  angle a b              Angle between a and b (radians and degrees)");
+    puts("  proj a b               Projection of a onto b");
     puts("  c = a + b              Operation w/ assignment (also -, *, s * a)");
-    puts("  c = cross a b          Assign cross product");
+    puts("  c = cross a b          Assign cross product (also norm a, proj a b)");
     puts("");
     puts("Storage");
     puts("  list                   List all stored vectors");
     puts("  clear                  Remove all vectors");
+    puts("  del <name>             Delete one vector");
+    puts("  compact (or shrink)    Release unused capacity (clear keeps it)");
+    puts("  mem                    Memory report");
+    puts("  mem chunk <n>          Grow in chunks of n vectors (power of two)");
+    puts("  mem huge off|thp|on    Back chunks >= 2 MiB with huge pages");
+    puts("  sort by <key> [asc|desc]");
+    puts("                         Reorder the store; key is mag, x, y, z or name");
+    puts("  top <k> by <key> [asc|desc] [save <file>]");
+    puts("                         Show (or save) the first k by key; numbers default");
+    puts("                         to largest first, names to A..Z");
+    puts("");
+    puts("Workspaces");
+    puts("  ws                     List workspaces (* = in use) and their checkpoints");
+    puts("  ws new <w>             Create an empty workspace");
+    puts("  ws fork <w>            Create a workspace as a copy of the current one");
+    puts("  ws use <w>             Switch workspace");
+    puts("  ws drop <w>            Delete a workspace");
+    puts("  checkpoint <tag>       Snapshot the current workspace (copy-on-write)");
+    puts("  rollback <tag>         Restore the snapshot (it can be reused)");
+    puts("  uncheckpoint <tag>     Forget a snapshot");
+    puts("");
+    puts("Shared memory (many processes, one writer)");
+    puts("  shm publish [name]     Copy the store into a shared segment (again = update)");
+    puts("  shm attach <name>      Map a segment read-only; its vectors become usable");
+    puts("                         by name wherever a local one is not found");
+    puts("  shm detach | list | info | unlink <name>");
+    puts("");
+    puts("Particles");
+    puts("  particles <p> <v> [f]  Pair vectors p<id> with v<id> (and force f<id>)");
+    puts("  particles              Show the particle set");
+    puts("  step <dt> [n] [euler|verlet] [snap <k> <file>]");
+    puts("                         Advance every particle n steps (default 1, verlet);");
+    puts("                         snap streams step,name,x,y,z every k steps");
+    puts("");
+    puts("Meshes");
+    puts("  mesh load <verts.csv> <faces>");
+    puts("                         Load a triangle list (faces: three vertex numbers");
+    puts("                         per line) and compute normals, areas, centroids");
+    puts("  mesh save faces <file> face,nx,ny,nz,area,cx,cy,cz per face");
+    puts("  mesh save normals <file>");
+    puts("                         Area-weighted vertex normals as name,x,y,z");
+    puts("  mesh | mesh free       Show / release the mesh");
+    puts("");
+    puts("Selections");
+    puts("  select <s> where <pred>");
+    puts("                         Name the vectors matching pred, e.g.");
+    puts("                         select hot where mag > 5 and z < 0 or name ^= p_");
+    puts("                         fields x y z mag (< <= > >= == !=), name (== != ^=)");
+    puts("  selections             List selections");
+    puts("  unselect <s>           Forget a selection");
+    puts("  apply @s + v | - v | * s");
+    puts("                         Update every selected vector in place");
+    puts("  stats [@s]             Count, min/max/mean of x y z mag");
+    puts("  save <file> @s         Save only the selected vectors");
+    puts("  del @s                 Delete the selected vectors");
     puts("");
     puts("CSV I/O");
     puts("  load <file>            Load CSV (clears current vectors first)");
     puts("                         CSV line format: name,x,y,z");
     puts("  save <file>            Save all vectors to CSV (overwrite)");
+    puts("  append <file>          Add rows from CSV; file values replace same names");
+    puts("  merge <file> [--keep first|last]");
+    puts("                         Add rows from CSV; pick which duplicate wins");
+    puts("");
+    puts("Background jobs");
+    puts("  load --async <file>    Load CSV on background threads (prompt stays live)");
+    puts("  jobs                   Show progress of the background load");
+    puts("  wait                   Block until the background load finishes");
+    puts("  cancel                 Stop the background load (store keeps its old contents)");
+    puts("");
+    puts("Workloads");
+    puts("  gen store <n> [prefix=v] [seed=1]");
+    puts("                         Add n random vectors named prefix0..prefix<n-1>");
+    puts("  gen trace <file> <ncmds> [names=N] [dist=uniform|zipf] [rate=R] [seed=S]");
+    puts("            [set=W get=W add=W sub=W dot=W cross=W select=W top=W sort=W]");
+    puts("                         Write a synthetic command trace for --replay");
+    puts("  Start with --record <file> to capture a session, and");
+    puts("  --replay <file> [--paced] [--echo] to run one and report latencies");
     puts("");
     puts("Other");
     puts("  help or -h or ?        Show this help");
     puts("  quit                   Exit program");
+    puts("");
+    printf("Batch math runs on %s kernels (VL_KERNELS=scalar|sse2|avx2|avx512 caps it)\n", vl_kernels());
     puts("------------------------------------------------------------\n");
 }
 
@@ -129,23 +259,13 @@ static int eval_binary_expr(const char *lhs_tok, const char *op, const char *rhs
 
 /* Handle: left = (numbers) | left = (expr) | left = cross a b */
 static void handle_assignment(char *left, char *right) {
-    trim(left); trim(right);
     if (!valid_name(left)) { puts("Error: invalid vector name."); return; }
 
     /* Try numbers first: x y z OR x,y,z OR x y (z=0) */
     {
-        char tmp[LINE_LEN];
-        strncpy(tmp, right, sizeof tmp - 1); tmp[sizeof tmp - 1] = '\0';
-        to_spaces(tmp);
-        char buf[LINE_LEN]; collapse_ws(tmp, buf, sizeof buf);
-
-        double x, y, z;
-        int n = sscanf(buf, "%lf %lf %lf", &x, &y, &z);
-        if (n == 3 || n == 2) {
-            if (n == 2) z = 0.0;
-            set_vector(left, x, y, z);
-            double v[3] = {x, y, z};
-            print_vec_named(left, v);
+        double v[3];
+        if (parse_vec3(right, v)) {
+            if (set_vector(left, v[0], v[1], v[2])) vl_print_vec(left, v);
             return;
         }
     }
@@ -158,8 +278,7 @@ static void handle_assignment(char *left, char *right) {
             if (!get_vector(a, va)) { puts("Error: left operand not found.");  return; }
             if (!get_vector(b, vb)) { puts("Error: right operand not found."); return; }
             v_cross(va, vb, r);
-            set_vector(left, r[0], r[1], r[2]);
-            print_vec_named(left, r);
+            if (set_vector(left, r[0], r[1], r[2])) vl_print_vec(left, r);
             return;
         } else {
             puts("Error: syntax: c = cross a b");
@@ -167,11 +286,38 @@ static void handle_assignment(char *left, char *right) {
         }
     }
 
-    /* Disallow assigning dot (scalar) into a vector. */
+    /* norm: b = norm a */
+    if (strncmp(right, "norm ", 5) == 0) {
+        char a[NAME_LEN] = {0};
+        if (sscanf(right + 5, "%31s", a) != 1) { puts("Error: syntax: b = norm a"); return; }
+        double va[3], r[3];
+        if (!get_vector(a, va)) { puts("Error: vector not found."); return; }
+        if (!v_normalize(va, r)) { puts("Error: cannot normalize a zero vector."); return; }
+        if (set_vector(left, r[0], r[1], r[2])) vl_print_vec(left, r);
+        return;
+    }
+
+    /* proj: c = proj a b (a projected onto b) */
+    if (strncmp(right, "proj ", 5) == 0) {
+        char a[NAME_LEN] = {0}, b[NAME_LEN] = {0};
+        if (sscanf(right + 5, "%31s %31s", a, b) != 2) { puts("Error: syntax: c = proj a b"); return; }
+        double va[3], vb[3], r[3];
+        if (!get_vector(a, va)) { puts("Error: left operand not found.");  return; }
+        if (!get_vector(b, vb)) { puts("Error: right operand not found."); return; }
+        if (!v_project(va, vb, r)) { puts("Error: cannot project onto a zero vector."); return; }
+        if (set_vector(left, r[0], r[1], r[2])) vl_print_vec(left, r);
+        return;
+    }
+
+    /* Disallow assigning scalars (dot, mag, angle) into a vector. */
     if (strncmp(right, "dot ", 4) == 0) {
         puts("Error: dot product is a scalar and cannot be assigned to a vector.");
         return;
     }
+    if (strncmp(right, "mag ", 4) == 0 || strncmp(right, "angle ", 6) == 0) {
+        puts("Error: mag and angle are scalars and cannot be assigned to a vector.");
+        return;
+    }
 
     /* Binary ops (Lab 5 style: spaces required around operators) */
     {
@@ -186,15 +332,14 @@ static void handle_assignment(char *left, char *right) {
 
             char *lhs = right;
             char *rhs = (op_plus ? op_plus + 3 : op_minus ? op_minus + 3 : op_mul + 3);
-            trim(lhs); trim(rhs);
+            lhs = strip(lhs); rhs = strip(rhs);
 
             double r[3];
             if (!eval_binary_expr(lhs, op, rhs, r)) {
                 puts("Error: invalid assignment expression.");
                 return;
             }
-            set_vector(left, r[0], r[1], r[2]);
-            print_vec_named(left, r);
+            if (set_vector(left, r[0], r[1], r[2])) vl_print_vec(left, r);
             return;
         }
     }
@@ -222,51 +367,86 @@ static void handle_expression(char *line) {
             if (!get_vector(a, va)) { puts("Error: left operand not found.");  return; }
             if (!get_vector(b, vb)) { puts("Error: right operand not found."); return; }
             v_cross(va, vb, r);
-            print_vec_named("ans", r);
+            vl_print_vec("ans", r);
             return;
         } else { puts("Error: syntax: cross a b"); return; }
     }
 
+    if (strncmp(line, "mag ", 4) == 0) {
+        char a[NAME_LEN] = {0};
+        double m;
+        if (sscanf(line + 4, "%31s", a) != 1) { puts("Error: syntax: mag a"); return; }
+        if (!get_mag(a, &m)) { puts("Error: vector not found."); return; }
+        printf("|%s| = %.3f\n", a, m);
+        return;
+    }
+    if (strncmp(line, "norm ", 5) == 0) {
+        char a[NAME_LEN] = {0};
+        double va[3], r[3];
+        if (sscanf(line + 5, "%31s", a) != 1) { puts("Error: syntax: norm a"); return; }
+        if (!get_vector(a, va)) { puts("Error: vector not found."); return; }
+        if (!v_normalize(va, r)) { puts("Error: cannot normalize a zero vector."); return; }
+        vl_print_vec("ans", r);
+        return;
+    }
+    if (strncmp(line, "angle ", 6) == 0 || strncmp(line, "proj ", 5) == 0) {
+        int is_angle = line[0] == 'a';
+        char a[NAME_LEN] = {0}, b[NAME_LEN] = {0};
+        if (sscanf(line + (is_angle ? 6 : 5), "%31s %31s", a, b) != 2) {
+            puts(is_angle ? "Error: syntax: angle a b" : "Error: syntax: proj a b");
+            return;
+        }
+        double va[3], vb[3], r[3];
+        if (!get_vector(a, va)) { puts("Error: left operand not found.");  return; }
+        if (!get_vector(b, vb)) { puts("Error: right operand not found."); return; }
+        if (is_angle) {
+            double t = v_angle(va, vb);
+            if (isnan(t)) { puts("Error: angle is undefined for a zero vector."); return; }
+            printf("angle(%s,%s) = %.3f rad (%.3f deg)\n", a, b, t, t * 180.0 / 3.14159265358979323846);
+        } else {
+            if (!v_project(va, vb, r)) { puts("Error: cannot project onto a zero vector."); return; }
+            vl_print_vec("ans", r);
+        }
+        return;
+    }
+
     char *op_plus  = strstr(line, " + ");
     char *op_minus = strstr(line, " - ");
     char *op_mul   = strstr(line, " * ");
 
     if (!op_plus && !op_minus && !op_mul) {
-        trim(line);
+        line = strip(line);
         if (!valid_name(line)) { puts("Error: invalid input."); return; }
         double v[3];
         if (!get_vector(line, v)) { puts("Error: vector not found."); return; }
-        print_vec_named(line, v);
+        vl_print_vec(line, v);
         return;
     }
 
     double res[3];
     if (op_plus) {
         *op_plus = '\0';
-        char *a = line, *b = op_plus + 3;
-        trim(a); trim(b);
+        char *a = strip(line), *b = strip(op_plus + 3);
         double va[3], vb[3];
         if (!get_vector(a, va)) { puts("Error: left operand not found.");  return; }
         if (!get_vector(b, vb)) { puts("Error: right operand not found."); return; }
         v_add(va, vb, res);
-        print_vec_named("ans", res);
+        vl_print_vec("ans", res);
         return;
     }
     if (op_minus) {
         *op_minus = '\0';
-        char *a = line, *b = op_minus + 3;
-        trim(a); trim(b);
+        char *a = strip(line), *b = strip(op_minus + 3);
         double va[3], vb[3];
         if (!get_vector(a, va)) { puts("Error: left operand not found.");  return; }
         if (!get_vector(b, vb)) { puts("Error: right operand not found."); return; }
         v_sub(va, vb, res);
-        print_vec_named("ans", res);
+        vl_print_vec("ans", res);
         return;
     }
     if (op_mul) {
         *op_mul = '\0';
-        char *lhs = line, *rhs = op_mul + 3;
-        trim(lhs); trim(rhs);
+        char *lhs = strip(line), *rhs = strip(op_mul + 3);
         double v[3], s;
         if (is_number(lhs)) {
             s = strtod(lhs, NULL);
@@ -280,52 +460,465 @@ static void handle_expression(char *line) {
             puts("Error: scalar multiplication requires one number and one vector.");
             return;
         }
-        print_vec_named("ans", res);
+        vl_print_vec("ans", res);
+        return;
+    }
+}
+
+/* Handle: sort by <key> [asc|desc] */
+static void handle_sort(char *args) {
+    char by[8] = {0}, keyname[8] = {0}, dir[8] = {0};
+    SortKey key;
+    int n = sscanf(args, "%7s %7s %7s", by, keyname, dir);
+    if (n < 2 || strcmp(by, "by") != 0 || !parse_sort_key(keyname, &key) ||
+        (n == 3 && strcmp(dir, "asc") != 0 && strcmp(dir, "desc") != 0)) {
+        puts("Error: syntax: sort by mag|x|y|z|name [asc|desc]");
+        return;
+    }
+
+    size_t *order = (size_t*)malloc((store_size() + 1) * sizeof *order);
+    if (!order) { puts("Error: out of memory."); return; }
+    size_t cnt = order_by(key, n == 3 && strcmp(dir, "desc") == 0, order);
+    int ok = cnt != VL_ERROR && (cnt != store_size() || store_permute(order));
+    free(order);
+    if (!ok) return;
+    printf("sorted %zu vectors by %s\n", cnt, keyname);
+}
+
+/* Handle: top <k> by <key> [asc|desc] [save <file>]
+ * Numeric keys default to largest first, names to A..Z. */
+static void handle_top(char *args) {
+    char by[8] = {0}, keyname[8] = {0};
+    unsigned long k = 0;
+    int used = 0;
+    SortKey key;
+    if (sscanf(args, "%lu %7s %7s%n", &k, by, keyname, &used) != 3 ||
+        strcmp(by, "by") != 0 || !parse_sort_key(keyname, &key)) {
+        puts("Error: syntax: top <k> by mag|x|y|z|name [asc|desc] [save <file>]");
+        return;
+    }
+
+    int desc = key != KEY_NAME;
+    const char *rest = args + used;
+    while (*rest == ' ') rest++;
+    if (strncmp(rest, "asc", 3) == 0)  { desc = 0; rest += 3; }
+    else if (strncmp(rest, "desc", 4) == 0) { desc = 1; rest += 4; }
+    while (*rest == ' ') rest++;
+    const char *fname = NULL;
+    if (strncmp(rest, "save ", 5) == 0) fname = rest + 5;
+    else if (*rest) { puts("Error: syntax: top <k> by mag|x|y|z|name [asc|desc] [save <file>]"); return; }
+
+    if (k > store_size()) k = store_size();
+    size_t *rows = (size_t*)malloc((k + 1) * sizeof *rows);
+    if (!rows) { puts("Error: out of memory."); return; }
+    size_t cnt = top_k(key, desc, k, rows);
+    if (cnt == VL_ERROR) {
+        free(rows);
+        return;
+    }
+    if (fname) {
+        if (save_csv_rows(fname, rows, cnt)) printf("saved %zu vectors to %s\n", cnt, fname);
+    } else {
+        for (size_t i = 0; i < cnt; ++i) vl_print_vec(store_at(rows[i])->name, store_at(rows[i])->v);
+        if (!cnt) puts("(no vectors stored)");
+    }
+    free(rows);
+}
+
+/* Handle: particles [<pos_prefix> <vel_prefix> [<force_prefix>]] */
+static void handle_particles(char *args) {
+    char p[NAME_LEN] = {0}, v[NAME_LEN] = {0}, f[NAME_LEN] = {0}, extra[2];
+    int n = sscanf(args, "%31s %31s %31s %1s", p, v, f, extra);
+    if (n <= 0) { particles_info(); return; }
+    if (n < 2 || n > 3) { puts("Error: syntax: particles <pos_prefix> <vel_prefix> [<force_prefix>]"); return; }
+    particles_define(p, v, n == 3 ? f : NULL);
+}
+
+/* Handle: step <dt> [n] [euler|verlet] [snap <k> <file>] */
+static void handle_step(char *args) {
+    static const char *syntax = "Error: syntax: step <dt> [n] [euler|verlet] [snap <k> <file>]";
+    char *tok[8];
+    int nt = 0;
+    for (char *t = strtok(args, " \t"); t && nt < 8; t = strtok(NULL, " \t")) tok[nt++] = t;
+    if (nt < 1 || !is_number(tok[0])) { puts(syntax); return; }
+
+    double dt = strtod(tok[0], NULL);
+    long n = 1, snap = 0;
+    int method = INTEG_VERLET, i = 1;
+    const char *file = NULL;
+    if (i < nt && is_number(tok[i])) {
+        n = strtol(tok[i++], NULL, 10);
+        if (n < 1) { puts(syntax); return; }
+    }
+    if (i < nt && strcmp(tok[i], "euler") == 0)  { method = INTEG_EULER;  i++; }
+    else if (i < nt && strcmp(tok[i], "verlet") == 0) { method = INTEG_VERLET; i++; }
+    if (i < nt && strcmp(tok[i], "snap") == 0) {
+        if (i + 2 >= nt || !is_number(tok[i + 1]) || (snap = strtol(tok[i + 1], NULL, 10)) < 1) {
+            puts(syntax);
+            return;
+        }
+        file = tok[i + 2];
+        i += 3;
+    }
+    if (i != nt || nt == 8) { puts(syntax); return; }
+    particles_step(dt, n, method, snap, file);
+}
+
+/* Handle: mesh [load <verts> <faces> | save faces|normals <file> | free] */
+static void handle_mesh(char *args) {
+    static const char *syntax = "Error: syntax: mesh [load <verts.csv> <faces> | save faces|normals <file> | free]";
+    char *tok[4];
+    int nt = 0;
+    for (char *t = strtok(args, " \t"); t && nt < 4; t = strtok(NULL, " \t")) tok[nt++] = t;
+    if (nt == 0) mesh_info();
+    else if (nt == 1 && strcmp(tok[0], "free") == 0) mesh_free();
+    else if (nt == 3 && strcmp(tok[0], "load") == 0) mesh_load(tok[1], tok[2]);
+    else if (nt == 3 && strcmp(tok[0], "save") == 0) mesh_save(tok[1], tok[2]);
+    else puts(syntax);
+}
+
+/* Handle: select <name> where <predicate> */
+static void handle_select(char *args) {
+    char *where = strstr(args, " where ");
+    if (!where) { puts("Error: syntax: select <name> where <predicate>"); return; }
+    *where = '\0';
+    args = strip(args);
+    if (!valid_name(args)) { puts("Error: invalid selection name."); return; }
+    sel_define(args, where + 7);
+}
+
+/* Handle: apply @sel + v | - v | * s */
+static void handle_apply(char *args) {
+    char ref[NAME_LEN + 1] = {0}, op[4] = {0}, operand[LINE_LEN] = {0};
+    if (sscanf(args, "%32s %3s %255s", ref, op, operand) != 3 ||
+        op[1] != '\0' || !strchr("+-*", op[0])) {
+        puts("Error: syntax: apply @sel + v | - v | * s");
+        return;
+    }
+    sel_apply(ref, op[0], operand);
+}
+
+/* Handle: mem | mem chunk <n> | mem huge off|thp|on */
+static void handle_mem(char *args) {
+    char what[8] = {0}, val[16] = {0};
+    int n = sscanf(args, "%7s %15s", what, val);
+    if (n <= 0) { mem_report(); return; }
+    if (n == 2 && strcmp(what, "chunk") == 0 && is_number(val) && strtod(val, NULL) >= 1) {
+        int r = store_set_chunk((size_t)strtod(val, NULL));
+        if (r == VL_ENOMEM) { puts("Error: out of memory."); return; }
+        if (r) { mem_report(); return; }
+    } else if (n == 2 && strcmp(what, "huge") == 0) {
+        if      (strcmp(val, "off") == 0) { store_set_huge(VL_HUGE_OFF); return; }
+        else if (strcmp(val, "thp") == 0) { store_set_huge(VL_HUGE_THP); return; }
+        else if (strcmp(val, "on")  == 0) { store_set_huge(VL_HUGE_ON);  return; }
+    }
+    puts("Error: syntax: mem | mem chunk <vectors> | mem huge off|thp|on");
+}
+
+/* Handle: ws | ws new|fork|use|drop <name> */
+static void handle_ws(char *args) {
+    char what[8] = {0}, name[NAME_LEN] = {0};
+    int n = sscanf(args, "%7s %31s", what, name);
+    if (n <= 0) { ws_list(); return; }
+    if (n != 2 || !valid_name(name)) { puts("Error: syntax: ws [new|fork|use|drop <name>]"); return; }
+
+    int switches = strcmp(what, "use") == 0 || strcmp(what, "drop") == 0;
+    if (switches && async_busy()) { puts("Error: a background load is running (use wait or cancel)."); return; }
+
+    if (strcmp(what, "new") == 0)       { if (ws_create(name, 0)) printf("created workspace %s\n", name); }
+    else if (strcmp(what, "fork") == 0) { if (ws_create(name, 1)) printf("forked %s from %s\n", name, ws_current()); }
+    else if (strcmp(what, "use") == 0)  { if (ws_use(name)) printf("using workspace %s (%zu vectors)\n", name, store_size()); }
+    else if (strcmp(what, "drop") == 0) { if (ws_drop(name)) printf("dropped workspace %s\n", name); }
+    else puts("Error: syntax: ws [new|fork|use|drop <name>]");
+}
+
+/* Handle: shm publish [name] | attach <name> | detach | list | info | unlink <name> */
+static void handle_shm(char *args) {
+    char what[8] = {0}, name[48] = {0};
+    int n = sscanf(args, "%7s %47s", what, name);
+    if (n >= 1 && strcmp(what, "publish") == 0) { shm_publish(n == 2 ? name : NULL); return; }
+    if (n == 2 && strcmp(what, "attach") == 0) {
+        if (shm_attach(name)) store_set_fallback(shm_lookup);
         return;
     }
+    if (n == 1 && strcmp(what, "detach") == 0) { shm_detach(); store_set_fallback(NULL); return; }
+    if (n == 1 && strcmp(what, "list") == 0)   { shm_list(); return; }
+    if (n == 1 && strcmp(what, "info") == 0)   { shm_info(); return; }
+    if (n == 2 && strcmp(what, "unlink") == 0) { if (shm_unlink_segment(name)) printf("removed %s\n", name); return; }
+    puts("Error: syntax: shm publish [name] | attach <name> | detach | list | info | unlink <name>");
 }
 
 /* ---------- main loop ---------- */
 
+/* Input from a regular file is read to the end without waiting on anyone,
+ * so stdout stays fully buffered. A terminal or pipe may be a client waiting
+ * for the reply, so flush unless more input is already waiting on the
+ * descriptor (that input ends at another prompt, which flushes). */
+static int input_is_file = 0;
+
+static int input_waiting(void) {
+    struct pollfd p = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&p, 1, 0) > 0 && (p.revents & POLLIN);
+}
+
+static void prompt(void) {
+    async_poll();
+    printf("minimat> ");
+    if (!input_is_file && !input_waiting()) fflush(stdout);
+}
+
+/* ---------- command table ---------- */
+
+static void handle_help(char *args)       { (void)args; print_help(); }
+static void handle_clear(char *args)      { (void)args; clear_store(); }
+static void handle_list(char *args)       { (void)args; list_store(); }
+static void handle_selections(char *args) { (void)args; sel_list(); }
+static void handle_unselect(char *args)   { sel_drop(args); }
+static void handle_gen(char *args)        { gen_command(args); }
+static void handle_append(char *args)     { merge_csv(args, 1); }
+static void handle_stats(char *args)      { sel_stats(*args ? args : NULL); }
+static void handle_jobs(char *args)       { (void)args; async_jobs(); }
+static void handle_wait(char *args)       { (void)args; async_wait(); }
+static void handle_cancel(char *args)     { (void)args; async_cancel(); }
+
+static void handle_checkpoint(char *args) {
+    char *tag = strip(args);
+    if (!valid_name(tag)) { puts("Error: invalid checkpoint tag."); return; }
+    if (checkpoint_create(tag)) printf("checkpoint %s: %zu vectors\n", tag, store_size());
+}
+
+static void handle_rollback(char *args) {
+    char *tag = strip(args);
+    if (async_busy()) { puts("Error: a background load is running (use wait or cancel)."); return; }
+    if (checkpoint_rollback(tag)) printf("rolled back to %s: %zu vectors\n", tag, store_size());
+}
+
+static void handle_uncheckpoint(char *args) {
+    char *tag = strip(args);
+    if (checkpoint_drop(tag)) printf("dropped checkpoint %s\n", tag);
+}
+
+static void handle_compact(char *args) {
+    (void)args;
+    size_t freed = store_shrink();
+    printf("released %zu bytes\n", freed);
+}
+
+static void handle_load(char *args) {
+    if (strncmp(args, "--async ", 8) == 0) { async_load_start(args + 8); return; }
+    if (async_busy()) { puts("Error: a background load is running (use wait or cancel)."); return; }
+    load_csv(args);
+}
+
+static void handle_save(char *args) {
+    char *at = strstr(args, " @");
+    if (at) { *at = '\0'; sel_save(at + 1, strip(args)); }
+    else save_csv(args);
+}
+
+static void handle_del(char *args) {
+    char *what = strip(args);
+    if (what[0] == '@') sel_delete(what);
+    else if (del_vector(what)) printf("deleted %s\n", what);
+    else if (store_find(what) < 0) puts("Error: vector not found.");   /* else out of memory, already reported */
+}
+
+static void handle_merge(char *args) {
+    char *fname = args;
+    int keep_last = 1;
+    char *opt = strstr(fname, " --keep ");
+    if (opt) {
+        *opt = '\0';
+        char *mode = strip(opt + 8);
+        if (strcmp(mode, "first") == 0) keep_last = 0;
+        else if (strcmp(mode, "last") != 0) { puts("Error: syntax: merge <file> [--keep first|last]"); return; }
+        fname = strip(fname);
+    }
+    merge_csv(fname, keep_last);
+}
+
+enum {
+    CMD_BARE   = 1,   /* the word alone */
+    CMD_ARGS   = 2,   /* the word, a space, then arguments */
+    CMD_NOLOCK = 4    /* job control: runs without the store lock so the loader can finish */
+};
+
+/* Every command word, for dispatch and for fast_assign, which must leave
+ * these lines alone. A NULL handler ends the session. */
+#define CMD(word, form, run) { word, sizeof word - 1, form, run }
+
+static const struct {
+    const char *word;
+    size_t len;
+    int form;
+    void (*run)(char *args);
+} commands[] = {
+    CMD("help",         CMD_BARE,               handle_help),
+    CMD("-h",           CMD_BARE,               handle_help),
+    CMD("?",            CMD_BARE,               handle_help),
+    CMD("quit",         CMD_BARE | CMD_NOLOCK,  NULL),
+    CMD("jobs",         CMD_BARE | CMD_NOLOCK,  handle_jobs),
+    CMD("wait",         CMD_BARE | CMD_NOLOCK,  handle_wait),
+    CMD("cancel",       CMD_BARE | CMD_NOLOCK,  handle_cancel),
+    CMD("clear",        CMD_BARE,               handle_clear),
+    CMD("list",         CMD_BARE,               handle_list),
+    CMD("ws",           CMD_BARE | CMD_ARGS,    handle_ws),
+    CMD("checkpoint",   CMD_ARGS,               handle_checkpoint),
+    CMD("rollback",     CMD_ARGS,               handle_rollback),
+    CMD("uncheckpoint", CMD_ARGS,               handle_uncheckpoint),
+    CMD("shm",          CMD_ARGS,               handle_shm),
+    CMD("compact",      CMD_BARE,               handle_compact),
+    CMD("shrink",       CMD_BARE,               handle_compact),
+    CMD("mem",          CMD_BARE | CMD_ARGS,    handle_mem),
+    CMD("load",         CMD_ARGS,               handle_load),
+    CMD("save",         CMD_ARGS,               handle_save),
+    CMD("particles",    CMD_BARE | CMD_ARGS,    handle_particles),
+    CMD("step",         CMD_ARGS,               handle_step),
+    CMD("mesh",         CMD_BARE | CMD_ARGS,    handle_mesh),
+    CMD("select",       CMD_ARGS,               handle_select),
+    CMD("selections",   CMD_BARE,               handle_selections),
+    CMD("unselect",     CMD_ARGS,               handle_unselect),
+    CMD("apply",        CMD_ARGS,               handle_apply),
+    CMD("stats",        CMD_BARE | CMD_ARGS,    handle_stats),
+    CMD("del",          CMD_ARGS,               handle_del),
+    CMD("sort",         CMD_ARGS,               handle_sort),
+    CMD("top",          CMD_ARGS,               handle_top),
+    CMD("gen",          CMD_ARGS,               handle_gen),
+    CMD("append",       CMD_ARGS,               handle_append),
+    CMD("merge",        CMD_ARGS,               handle_merge),
+};
+#undef CMD
+#define NCOMMANDS (sizeof commands / sizeof commands[0])
+
+/* Index of the command this line invokes, or -1. Its arguments start at
+ * line + *args: after the word and its space (at the end for the bare word). */
+static int find_command(const char *line, size_t *args) {
+    size_t n = strcspn(line, " ");
+    int form = line[n] ? CMD_ARGS : CMD_BARE;
+    for (size_t i = 0; i < NCOMMANDS; ++i) {
+        if (commands[i].len != n || !(commands[i].form & form) || memcmp(line, commands[i].word, n) != 0) continue;
+        *args = line[n] ? n + 1 : n;
+        return (int)i;
+    }
+    return -1;
+}
+
+/* Report group for --replay: the command word (aliases under the first name
+ * in the table), else assign, expr for arithmetic, print for a lone name,
+ * or the leading word (dot, mag, ...). */
+static void classify_line(const char *line, char *out, size_t outsz) {
+    size_t skip;
+    while (isspace((unsigned char)*line)) line++;
+    int c = find_command(line, &skip);
+    if (c >= 0) {
+        int first = 0;
+        while (commands[first].run != commands[c].run) first++;
+        snprintf(out, outsz, "%s", commands[first].word);
+    } else if (strchr(line, '=')) {
+        snprintf(out, outsz, "assign");
+    } else if (strstr(line, " + ") || strstr(line, " - ") || strstr(line, " * ")) {
+        snprintf(out, outsz, "expr");
+    } else {
+        size_t n = strcspn(line, " \t");
+        if (line[n]) snprintf(out, outsz, "%.*s", (int)n, line);
+        else         snprintf(out, outsz, "print");
+    }
+}
+
+/* Anything that is not a command: an assignment or an expression.
+ * Caller holds the store lock. */
+static void run_statement(char *line) {
+    char *eq = strchr(line, '=');
+    if (eq) {
+        *eq = '\0';
+        char *left = strip(line), *right = strip(eq + 1);
+        if (!*left || !*right) { puts("Error: invalid assignment."); return; }
+        if (strlen(left) >= NAME_LEN) left[NAME_LEN - 1] = '\0';
+        handle_assignment(left, right);
+        return;
+    }
+
+    handle_expression(line);
+}
+
+/* Bulk-load fast path for `name = <numbers>`: one pass over the line, in
+ * place. Only called for lines that are not commands. Returns 0 (line
+ * untouched) for anything else. */
+static int fast_assign(char *line) {
+    char *p = line;
+    while (isalnum((unsigned char)*p) || *p == '_') p++;
+    size_t len = (size_t)(p - line);
+    if (!len || len >= NAME_LEN) return 0;
+    char *name_end = p;
+    while (*p == ' ' || *p == '\t') p++;
+    if (*p != '=') return 0;
+
+    double v[3];
+    if (!parse_vec3(p + 1, v)) return 0;
+    *name_end = '\0';
+
+    async_lock();
+    int ok = set_vector(line, v[0], v[1], v[2]);
+    async_unlock();
+    if (ok) vl_print_vec(line, v);
+    return 1;
+}
+
+/* Run one raw input line; returns 0 on quit. Shared by the REPL and --replay. */
+static int handle_line(char *line) {
+    line = strip(line);
+    if (!*line) return 1;
+
+    size_t skip = 0;
+    int c = find_command(line, &skip);
+    char *args = line + skip;
+    if (c < 0 && fast_assign(line)) return 1;
+    if (c >= 0 && !commands[c].run) return 0;
+    if (c >= 0 && (commands[c].form & CMD_NOLOCK)) { commands[c].run(args); return 1; }
+
+    async_lock();
+    if (c >= 0) commands[c].run(args);
+    else run_statement(line);
+    async_unlock();
+    return 1;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [-h] [--record <trace>] [--replay <trace> [--paced] [--echo]]\n", prog);
+}
+
 int main(int argc, char **argv) {
     init_store();
     atexit(free_store);
-
-    if (argc == 2 && (strcmp(argv[1], "-h") == 0)) {
-        print_help();
-        return 0;
+    atexit(sel_free_all);
+    atexit(trace_record_close);
+    atexit(shm_close_all);
+    atexit(async_shutdown); /* registered last, so it runs first: stop loader threads before freeing */
+
+    const char *record = NULL, *replay = NULL;
+    int paced = 0, echo = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-h") == 0) { print_help(); return 0; }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) record = argv[++i];
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) replay = argv[++i];
+        else if (strcmp(argv[i], "--paced") == 0) paced = 1;
+        else if (strcmp(argv[i], "--echo") == 0)  echo = 1;
+        else { usage(argv[0]); return 1; }
     }
 
-    char line[LINE_LEN];
-    printf("minimat> "); fflush(stdout);
-
-    while (fgets(line, sizeof(line), stdin)) {
-        trim(line);
-        if (!*line) { printf("minimat> "); fflush(stdout); continue; }
-
-        if (strcmp(line, "quit") == 0) break;
-        if (strcmp(line, "help") == 0 || strcmp(line, "-h") == 0 || strcmp(line, "?") == 0) { print_help(); printf("minimat> "); fflush(stdout); continue; }
-        if (strcmp(line, "clear") == 0) { clear_store(); printf("minimat> "); fflush(stdout); continue; }
-        if (strcmp(line, "list")  == 0) { list_store();  printf("minimat> "); fflush(stdout); continue; }
-
-        if (strncmp(line, "load ", 5) == 0) { load_csv(line + 5); printf("minimat> "); fflush(stdout); continue; }
-        if (strncmp(line, "save ", 5) == 0) { save_csv(line + 5); printf("minimat> "); fflush(stdout); continue; }
-
-        char *eq = strchr(line, '=');
-        if (eq) {
-            *eq = '\0';
-            char left[NAME_LEN], rhs_raw[LINE_LEN];
-            strncpy(left, line, sizeof left - 1); left[sizeof left - 1] = '\0';
-            strncpy(rhs_raw, eq + 1, sizeof rhs_raw - 1); rhs_raw[sizeof rhs_raw - 1] = '\0';
-            trim(left); trim(rhs_raw);
-            if (!*left || !*rhs_raw) { puts("Error: invalid assignment."); printf("minimat> "); fflush(stdout); continue; }
-            handle_assignment(left, rhs_raw);
-            printf("minimat> "); fflush(stdout);
-            continue;
-        }
+    if (replay) return trace_replay(replay, paced, echo, handle_line, classify_line) ? 0 : 1;
+    if (record && !trace_record_open(record)) return 1;
+
+    char buf[LINE_LEN];
+    struct stat st;
+    input_is_file = fstat(STDIN_FILENO, &st) == 0 && S_ISREG(st.st_mode);
+    prompt();
 
-        handle_expression(line);
-        printf("minimat> "); fflush(stdout);
+    while (fgets(buf, sizeof(buf), stdin)) {
+        char *line = strip(buf);
+        if (*line) trace_record(line);
+        if (!handle_line(line)) break;
+        prompt();
     }
 
     return 0;
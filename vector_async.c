@@ -0,0 +1,341 @@
+/* Filename: vector_async.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Background CSV loader (reader thread -> double buffer -> parser
+ *              thread -> private staging store). The finished load replaces
+ *              the current workspace's vectors in one step under the store
+ *              lock; until then commands see the previous contents.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+#include "vector_update.h"
+#include "vector_async.h"
+
+#define BLOCK_SIZE (1u << 20)   /* bytes per read buffer */
+#define BATCH_ROWS 4096         /* rows parsed between inserts */
+#define LINE_CAP   256          /* same limit as load_csv */
+
+enum { JOB_NONE, JOB_RUNNING, JOB_DONE, JOB_CANCELLED, JOB_FAILED };
+
+typedef struct {
+    char  *data;
+    size_t len;
+    int    full;               /* 1 = filled by reader, waiting for parser */
+} Block;
+
+typedef struct {
+    int    id;
+    char   fname[LINE_CAP];
+    FILE  *fp;
+    size_t total;              /* file size from stat (sizes the staging store), 0 if unknown */
+
+    Block  buf[2];
+    pthread_mutex_t mtx;       /* guards buf[] */
+    pthread_cond_t  cv;
+    pthread_t reader, parser;
+    int    joined;
+    int    reported;
+
+    atomic_int    state;       /* changed only by the parser once running */
+    atomic_int    cancel;
+    atomic_int    read_error;  /* set by the reader, acted on by the parser */
+    atomic_size_t bytes_read;
+    atomic_size_t rows;
+    atomic_size_t bad;
+    size_t vectors;            /* distinct names in the finished load (set by the parser) */
+
+    /* parser-private */
+    vl_store *staged;          /* the rows loaded so far */
+    int    nomem;              /* staging store ran out of memory: load fails */
+    char   carry[LINE_CAP];
+    size_t carry_len;
+    int    carry_over;         /* current line did not fit in carry */
+    Vec    batch[BATCH_ROWS];
+    size_t nbatch;
+} LoadJob;
+
+static pthread_mutex_t store_mtx = PTHREAD_MUTEX_INITIALIZER;
+static LoadJob *job = NULL;
+static int next_id = 1;
+
+void async_lock(void)   { pthread_mutex_lock(&store_mtx); }
+void async_unlock(void) { pthread_mutex_unlock(&store_mtx); }
+
+/* ---------- reader ---------- */
+
+static void *reader_main(void *arg) {
+    LoadJob *j = arg;
+    int i = 0;
+    for (;;) {
+        pthread_mutex_lock(&j->mtx);
+        while (j->buf[i].full && !atomic_load(&j->cancel))
+            pthread_cond_wait(&j->cv, &j->mtx);
+        pthread_mutex_unlock(&j->mtx);
+        if (atomic_load(&j->cancel)) break;
+
+        /* buf[i] is empty, so the parser will not touch it until we hand it over */
+        size_t n = fread(j->buf[i].data, 1, BLOCK_SIZE, j->fp);
+        if (n == 0 && ferror(j->fp)) atomic_store(&j->read_error, 1);
+        atomic_fetch_add(&j->bytes_read, n);
+
+        pthread_mutex_lock(&j->mtx);
+        j->buf[i].len = n;       /* len 0 tells the parser we hit EOF */
+        j->buf[i].full = 1;
+        pthread_cond_broadcast(&j->cv);
+        pthread_mutex_unlock(&j->mtx);
+        if (n == 0) break;
+        i ^= 1;
+    }
+    return NULL;
+}
+
+/* ---------- parser ---------- */
+
+static void flush_batch(LoadJob *j) {
+    if (j->nbatch && !j->nomem) {
+        if (vl_append(j->staged, j->batch, j->nbatch, 1) == VL_ERROR) j->nomem = 1;
+        else atomic_fetch_add(&j->rows, j->nbatch);
+    }
+    j->nbatch = 0;             /* rows after a failure are dropped */
+}
+
+static void finish_line(LoadJob *j) {
+    size_t n = j->carry_len;
+    char *line = j->carry;
+    int over = j->carry_over;
+    j->carry_len = 0;
+    j->carry_over = 0;
+
+    if (over) { atomic_fetch_add(&j->bad, 1); return; }
+    line[n] = '\0';
+    while (n && (unsigned char)line[n-1] <= ' ') line[--n] = '\0';
+    if (!n) return;
+
+    Vec *r = &j->batch[j->nbatch];
+    if (sscanf(line, "%31[^,],%lf,%lf,%lf", r->name, &r->v[0], &r->v[1], &r->v[2]) == 4) {
+        if (++j->nbatch == BATCH_ROWS) flush_batch(j);
+    } else {
+        atomic_fetch_add(&j->bad, 1);
+    }
+}
+
+static void parse_block(LoadJob *j, const char *p, size_t n) {
+    const char *end = p + n;
+    while (p < end) {
+        const char *nl = memchr(p, '\n', (size_t)(end - p));
+        size_t len = (size_t)((nl ? nl : end) - p);
+        if (j->carry_len + len < sizeof j->carry) {
+            memcpy(j->carry + j->carry_len, p, len);
+            j->carry_len += len;
+        } else {
+            j->carry_over = 1;
+        }
+        if (!nl) break;
+        finish_line(j);
+        p = nl + 1;
+    }
+}
+
+/* Pre-size the staging store once, from the file size and the line length
+ * of the first block, so the batches that follow never grow it. */
+static void reserve_rows(LoadJob *j, const char *p, size_t n) {
+    size_t lines = 0;
+    for (const char *q = p, *end = p + n; (q = memchr(q, '\n', (size_t)(end - q))); ++q) lines++;
+    if (!j->total || !lines) return;
+    if (vl_reserve(j->staged, (size_t)((double)j->total * (double)lines / (double)n) + 1) < 0)
+        vl_shrink(j->staged);  /* only a hint: give back what it got */
+}
+
+static void *parser_main(void *arg) {
+    LoadJob *j = arg;
+    int i = 0, first = 1;
+    for (;;) {
+        pthread_mutex_lock(&j->mtx);
+        while (!j->buf[i].full && !atomic_load(&j->cancel))
+            pthread_cond_wait(&j->cv, &j->mtx);
+        pthread_mutex_unlock(&j->mtx);
+        if (atomic_load(&j->cancel) || j->nomem) break;
+
+        size_t n = j->buf[i].len;
+        if (n && first) { reserve_rows(j, j->buf[i].data, n); first = 0; }
+        if (n) parse_block(j, j->buf[i].data, n);
+
+        pthread_mutex_lock(&j->mtx);
+        j->buf[i].full = 0;
+        pthread_cond_broadcast(&j->cv);
+        pthread_mutex_unlock(&j->mtx);
+        if (!n) break;
+        i ^= 1;
+    }
+
+    if (!atomic_load(&j->cancel) && !j->nomem && (j->carry_len || j->carry_over)) finish_line(j);
+    flush_batch(j);
+    if (j->nomem) {            /* stopped early: let the reader run out too */
+        atomic_store(&j->cancel, 1);
+        pthread_mutex_lock(&j->mtx);
+        pthread_cond_broadcast(&j->cv);
+        pthread_mutex_unlock(&j->mtx);
+    }
+
+    /* Only this thread ends the job. Swap and state change share one lock
+     * hold, so a command sees either the old vectors with the job running or
+     * the loaded ones with it done. Cancelled or failed: nothing changes. */
+    int failed = atomic_load(&j->read_error) || j->nomem;
+    int cancelled = !j->nomem && atomic_load(&j->cancel);
+    j->vectors = vl_size(j->staged);
+    async_lock();
+    if (!failed && !cancelled) store_swap_in(j->staged);
+    atomic_store(&j->state, failed ? JOB_FAILED : cancelled ? JOB_CANCELLED : JOB_DONE);
+    async_unlock();
+    vl_close(j->staged);       /* now the previous vectors, or the partial load */
+    j->staged = NULL;
+    return NULL;
+}
+
+/* ---------- job control ---------- */
+
+static void free_job(LoadJob *j) {
+    if (!j) return;
+    if (j->fp) fclose(j->fp);
+    vl_close(j->staged);
+    free(j->buf[0].data);
+    free(j->buf[1].data);
+    pthread_mutex_destroy(&j->mtx);
+    pthread_cond_destroy(&j->cv);
+    free(j);
+}
+
+static void join_job(LoadJob *j) {
+    if (!j || j->joined) return;
+    pthread_join(j->reader, NULL);
+    pthread_join(j->parser, NULL);
+    j->joined = 1;
+}
+
+static const char *state_name(int s) {
+    switch (s) {
+        case JOB_RUNNING:   return "running";
+        case JOB_DONE:      return "done";
+        case JOB_CANCELLED: return "cancelled";
+        case JOB_FAILED:    return "failed";
+        default:            return "idle";
+    }
+}
+
+int async_busy(void) {
+    return job && atomic_load(&job->state) == JOB_RUNNING;
+}
+
+int async_load_start(const char *fname) {
+    if (async_busy()) { puts("Error: a background load is already running (use wait or cancel)."); return 0; }
+
+    FILE *fp = fopen(fname, "r");
+    if (!fp) { printf("Error: cannot open %s\n", fname); return 0; }
+
+    /* Previous job is finished; drop it before starting a new one. */
+    if (job) { join_job(job); free_job(job); job = NULL; }
+
+    LoadJob *j = calloc(1, sizeof *j);
+    if (!j) { fclose(fp); puts("Error: out of memory."); return 0; }
+    pthread_mutex_init(&j->mtx, NULL);
+    pthread_cond_init(&j->cv, NULL);
+    j->fp = fp;                /* free_job closes it from here on */
+    j->buf[0].data = malloc(BLOCK_SIZE);
+    j->buf[1].data = malloc(BLOCK_SIZE);
+    if (!j->buf[0].data || !j->buf[1].data) {
+        puts("Error: out of memory.");
+        free_job(j);
+        return 0;
+    }
+    j->id = next_id++;
+    strncpy(j->fname, fname, sizeof j->fname - 1);
+    struct stat st;
+    if (fstat(fileno(fp), &st) == 0 && st.st_size > 0) j->total = (size_t)st.st_size;
+    atomic_init(&j->state, JOB_RUNNING);
+    atomic_init(&j->cancel, 0);
+    atomic_init(&j->bytes_read, 0);
+    atomic_init(&j->rows, 0);
+    atomic_init(&j->bad, 0);
+    atomic_init(&j->read_error, 0);
+    j->staged = store_staging();
+    if (!j->staged) {
+        puts("Error: out of memory.");
+        free_job(j);
+        return 0;
+    }
+
+    if (pthread_create(&j->reader, NULL, reader_main, j) != 0) {
+        puts("Error: cannot start loader thread.");
+        free_job(j);
+        return 0;
+    }
+    if (pthread_create(&j->parser, NULL, parser_main, j) != 0) {
+        puts("Error: cannot start loader thread.");
+        atomic_store(&j->cancel, 1);
+        pthread_cond_broadcast(&j->cv);
+        pthread_join(j->reader, NULL);
+        free_job(j);
+        return 0;
+    }
+    job = j;
+    printf("[%d] loading %s in background\n", j->id, j->fname);
+    return 1;
+}
+
+void async_jobs(void) {
+    if (!job) { puts("(no background jobs)"); return; }
+    size_t done = atomic_load(&job->bytes_read);
+    double pct = job->total ? 100.0 * (double)done / (double)job->total : 0.0;
+    if (pct > 100.0) pct = 100.0;
+    printf("[%d] %-9s %s  %.1f%% (%zu / %zu bytes)  rows=%zu  bad=%zu\n",
+           job->id, state_name(atomic_load(&job->state)), job->fname, pct,
+           done, job->total, atomic_load(&job->rows), atomic_load(&job->bad));
+}
+
+void async_poll(void) {
+    if (!job || job->reported || atomic_load(&job->state) == JOB_RUNNING) return;
+    join_job(job);
+    job->reported = 1;
+    int s = atomic_load(&job->state);
+    if (s != JOB_DONE) {
+        printf("[%d] %s: %s not loaded, store unchanged\n", job->id, state_name(s), job->fname);
+        return;
+    }
+    printf("[%d] %s: %zu vectors (%zu rows) from %s", job->id, state_name(s),
+           job->vectors, atomic_load(&job->rows), job->fname);
+    if (atomic_load(&job->bad)) printf(" (%zu bad lines ignored)", atomic_load(&job->bad));
+    putchar('\n');
+}
+
+void async_wait(void) {
+    if (!job) { puts("(no background jobs)"); return; }
+    join_job(job);
+    async_poll();
+}
+
+void async_cancel(void) {
+    if (!async_busy()) { puts("(no running job)"); return; }
+    atomic_store(&job->cancel, 1);
+    pthread_mutex_lock(&job->mtx);
+    pthread_cond_broadcast(&job->cv);
+    pthread_mutex_unlock(&job->mtx);
+    join_job(job);
+    async_poll();
+}
+
+void async_shutdown(void) {
+    if (!job) return;
+    atomic_store(&job->cancel, 1);
+    pthread_mutex_lock(&job->mtx);
+    pthread_cond_broadcast(&job->cv);
+    pthread_mutex_unlock(&job->mtx);
+    join_job(job);
+    free_job(job);
+    job = NULL;
+}
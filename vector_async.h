@@ -0,0 +1,25 @@
+/* Filename: vector_async.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Background CSV loading. A reader thread and a parser thread
+ *              share a double buffer; parsed rows go into a staging store that
+ *              replaces the current workspace's vectors when the load completes.
+ */
+#ifndef VECTOR_ASYNC_H
+#define VECTOR_ASYNC_H
+
+/* Store lock. The REPL holds it while a command runs, the loader while it
+ * swaps the finished load in, so every command sees the old or the new store. */
+void async_lock(void);
+void async_unlock(void);
+
+/* Job control */
+int  async_load_start(const char *fname); // replaces the store on success, like load_csv
+void async_jobs(void);                    // print progress of the current job
+void async_wait(void);                    // block until the job finishes
+void async_cancel(void);                  // stop the job, store keeps its old contents
+int  async_busy(void);                    // 1 while a job is still running
+void async_poll(void);                    // report a finished job once
+void async_shutdown(void);                // cancel + join (safe to call at exit)
+
+#endif /* VECTOR_ASYNC_H */
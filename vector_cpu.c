@@ -0,0 +1,125 @@
+/* Filename: vector_cpu.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Builds vector_kernels.inc once per instruction set (scalar,
+ *              and on x86 SSE2, AVX2, AVX-512) through target attributes, so
+ *              the makefile needs no -m flags, and selects one with
+ *              __builtin_cpu_supports when the library is loaded.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "vector_cpu.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define VK_X86 1
+#include <immintrin.h>
+#endif
+
+/* ---------- scalar (any CPU) ---------- */
+
+#define KNAME(f)      f##_scalar
+#define KATTR
+#define KVEC          double
+#define KW            1
+#define KLOAD(p)      (*(p))
+#define KSTORE(p, v)  (*(p) = (v))
+#define KADD(a, b)    ((a) + (b))
+#define KSUB(a, b)    ((a) - (b))
+#define KMUL(a, b)    ((a) * (b))
+#define KSET1(s)      (s)
+#define KRSQRT_EST(x) (1.0 / sqrt(x))
+#define KNEWTON       0
+#include "vector_kernels.inc"
+
+#if defined(VK_X86)
+
+/* ---------- SSE2: 12-bit float estimate ---------- */
+
+#define KNAME(f)      f##_sse2
+#define KATTR         __attribute__((target("sse2")))
+#define KVEC          __m128d
+#define KW            2
+#define KLOAD         _mm_loadu_pd
+#define KSTORE        _mm_storeu_pd
+#define KADD          _mm_add_pd
+#define KSUB          _mm_sub_pd
+#define KMUL          _mm_mul_pd
+#define KSET1         _mm_set1_pd
+#define KRSQRT_EST(x) _mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(x)))
+#define KNEWTON       3
+#include "vector_kernels.inc"
+
+/* ---------- AVX2 ---------- */
+
+#define KNAME(f)      f##_avx2
+#define KATTR         __attribute__((target("avx2")))
+#define KVEC          __m256d
+#define KW            4
+#define KLOAD         _mm256_loadu_pd
+#define KSTORE        _mm256_storeu_pd
+#define KADD          _mm256_add_pd
+#define KSUB          _mm256_sub_pd
+#define KMUL          _mm256_mul_pd
+#define KSET1         _mm256_set1_pd
+#define KRSQRT_EST(x) _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(x)))
+#define KNEWTON       3
+#include "vector_kernels.inc"
+
+/* ---------- AVX-512: 14-bit double estimate ---------- */
+
+#define KNAME(f)      f##_avx512
+#define KATTR         __attribute__((target("avx512f")))
+#define KVEC          __m512d
+#define KW            8
+#define KLOAD         _mm512_loadu_pd
+#define KSTORE        _mm512_storeu_pd
+#define KADD          _mm512_add_pd
+#define KSUB          _mm512_sub_pd
+#define KMUL          _mm512_mul_pd
+#define KSET1         _mm512_set1_pd
+#define KRSQRT_EST    _mm512_rsqrt14_pd
+#define KNEWTON       3
+#include "vector_kernels.inc"
+
+#endif /* VK_X86 */
+
+#define VK_ENTRY(isa) { #isa, k_sub_##isa, k_cross_##isa, k_norm2_##isa, k_rsqrt_##isa }
+
+/* Weakest first; the last one the CPU supports wins. */
+static const vk_table variants[] = {
+    VK_ENTRY(scalar),
+#if defined(VK_X86)
+    VK_ENTRY(sse2),
+    VK_ENTRY(avx2),
+    VK_ENTRY(avx512),
+#endif
+};
+
+#if defined(VK_X86) && defined(__SSE2__)
+vk_table vk = VK_ENTRY(sse2);
+#else
+vk_table vk = VK_ENTRY(scalar);
+#endif
+
+static int supported(const char *name) {
+#if defined(VK_X86)
+    if (strcmp(name, "sse2") == 0)   return __builtin_cpu_supports("sse2");
+    if (strcmp(name, "avx2") == 0)   return __builtin_cpu_supports("avx2");
+    if (strcmp(name, "avx512") == 0) return __builtin_cpu_supports("avx512f");
+#endif
+    return strcmp(name, "scalar") == 0;
+}
+
+__attribute__((constructor)) static void vk_select(void) {
+#if defined(VK_X86)
+    __builtin_cpu_init();
+#endif
+    const char *cap = getenv("VL_KERNELS");
+    for (size_t i = 0; i < sizeof variants / sizeof variants[0]; ++i) {
+        if (!supported(variants[i].name)) continue;
+        vk = variants[i];
+        if (cap && strcmp(cap, variants[i].name) == 0) break;
+    }
+}
@@ -0,0 +1,25 @@
+/* Filename: vector_cpu.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Runtime kernel dispatch (internal to libvector). The batch
+ *              kernels are built for several instruction sets; the best one
+ *              the running CPU supports is picked once, at load time.
+ */
+#ifndef VECTOR_CPU_H
+#define VECTOR_CPU_H
+
+#include <stddef.h>
+
+typedef struct {
+    const char *name;
+    void (*sub)  (const double *a, const double *b, double *r, size_t len);
+    void (*cross)(const double (*a)[3], const double (*b)[3], double (*r)[3], size_t n);
+    void (*norm2)(const double (*a)[3], double *out, size_t n);
+    void (*rsqrt)(const double *x, double *out, size_t n);
+} vk_table;
+
+/* Valid from the start (baseline kernels); upgraded before main runs.
+ * VL_KERNELS=scalar|sse2|avx2|avx512 in the environment caps the choice. */
+extern vk_table vk;
+
+#endif /* VECTOR_CPU_H */
@@ -0,0 +1,70 @@
+/* Filename: vector_mem.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Chunk allocation with optional huge-page backing.
+ */
+#define _DEFAULT_SOURCE   /* MAP_ANONYMOUS, MAP_HUGETLB, madvise */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "vector_mem.h"
+
+static void *try_mmap(size_t bytes, int flags) {
+    void *p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return p == MAP_FAILED ? NULL : p;
+}
+
+MemBlock mem_alloc(size_t bytes, int huge_mode) {
+    MemBlock b = { NULL, bytes, MEM_MALLOC };
+
+    /* Huge pages only pay off (and only fit) for chunks of 2 MiB or more. */
+    if (huge_mode != VL_HUGE_OFF && bytes >= HUGE_PAGE_SIZE) {
+        size_t len = (bytes + HUGE_PAGE_SIZE - 1) & ~(size_t)(HUGE_PAGE_SIZE - 1);
+#ifdef MAP_HUGETLB
+        if (huge_mode == VL_HUGE_ON && (b.ptr = try_mmap(len, MAP_HUGETLB)) != NULL) {
+            b.bytes = len;
+            b.kind = MEM_HUGETLB;
+            return b;
+        }
+#endif
+        if ((b.ptr = try_mmap(len, 0)) != NULL) {
+            b.bytes = len;
+            b.kind = MEM_MMAP;
+#ifdef MADV_HUGEPAGE
+            if (madvise(b.ptr, len, MADV_HUGEPAGE) == 0) b.kind = MEM_THP;
+#endif
+            return b;   /* anonymous mappings are already zeroed */
+        }
+    }
+
+    b.ptr = calloc(1, bytes);
+    return b;
+}
+
+void mem_free(MemBlock *b) {
+    if (!b->ptr) return;
+    if (b->kind == MEM_MALLOC) free(b->ptr);
+    else munmap(b->ptr, b->bytes);
+    b->ptr = NULL;
+    b->bytes = 0;
+}
+
+const char *mem_kind_name(int kind) {
+    switch (kind) {
+        case MEM_MALLOC:  return "malloc";
+        case MEM_MMAP:    return "mmap";
+        case MEM_THP:     return "mmap+THP";
+        case MEM_HUGETLB: return "hugetlb";
+    }
+    return "?";
+}
+
+const char *huge_mode_name(int mode) {
+    switch (mode) {
+        case VL_HUGE_OFF: return "off";
+        case VL_HUGE_THP: return "thp";
+        case VL_HUGE_ON:  return "on";
+    }
+    return "?";
+}
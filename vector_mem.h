@@ -0,0 +1,30 @@
+/* Filename: vector_mem.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Chunk allocator for the vector store. Large chunks can be
+ *              backed by explicit huge pages (MAP_HUGETLB) or transparent
+ *              huge pages (madvise), small ones come from malloc.
+ */
+#ifndef VECTOR_MEM_H
+#define VECTOR_MEM_H
+
+#include <stddef.h>
+#include "libvector.h"   /* VL_HUGE_* policy */
+
+#define HUGE_PAGE_SIZE (2u << 20)
+
+enum { MEM_MALLOC, MEM_MMAP, MEM_THP, MEM_HUGETLB, MEM_KINDS }; /* what we got */
+
+typedef struct {
+    void  *ptr;
+    size_t bytes;   /* usable (and mapped) length */
+    int    kind;
+} MemBlock;
+
+/* Zero-filled block of at least `bytes`; ptr is NULL on out-of-memory. */
+MemBlock    mem_alloc(size_t bytes, int huge_mode);
+void        mem_free(MemBlock *b);
+const char *mem_kind_name(int kind);
+const char *huge_mode_name(int mode);
+
+#endif /* VECTOR_MEM_H */
@@ -0,0 +1,321 @@
+/* Filename: vector_mesh.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Triangle mesh loading and per-face / per-vertex geometry.
+ *              Faces are processed in tiles: corners are gathered into packed
+ *              arrays and run through v_sub_batch, v_cross_batch and the
+ *              length batches. Each thread sums its face normals into its own
+ *              vertex array; a second pass adds those up and normalizes.
+ */
+#define _POSIX_C_SOURCE 200809L   /* sysconf, clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "libvector.h"
+#include "vector_mesh.h"
+
+#define MAX_THREADS    16
+#define MIN_PER_THREAD 16384  /* faces; smaller shares cost more to start than they save */
+#define TILE           256    /* faces gathered per batch */
+
+typedef struct {
+    size_t nv, nf;
+    char   (*name)[NAME_LEN];
+    double (*vert)[3];
+    size_t (*face)[3];
+    double (*fn)[3];           /* unit face normals */
+    double *area;
+    double (*fc)[3];           /* centroids */
+    double (*vn)[3];           /* unit, area-weighted vertex normals */
+    double total_area;
+    size_t degenerate;         /* faces of zero area */
+    int    threads;
+    double secs;
+} Mesh;
+
+typedef struct {
+    Mesh   *m;
+    size_t  lo, hi;            /* faces, then vertices in the second pass */
+    double (*acc)[3];          /* this thread's vertex sums */
+    double (**parts)[3];       /* every thread's sums (second pass) */
+    int     nparts;
+    double  area;
+    size_t  degenerate;
+} Work;
+
+static Mesh mesh;
+static int  have_mesh = 0;
+
+/* Both give NULL (and the message) when memory runs out, and the command
+ * fails; xrealloc then leaves p allocated. */
+static void *xmalloc(size_t n) {
+    void *p = malloc(n ? n : 1);
+    if (!p) puts("Error: out of memory.");
+    return p;
+}
+
+static void *xrealloc(void *p, size_t n) {
+    void *q = realloc(p, n ? n : 1);
+    if (!q) puts("Error: out of memory.");
+    return q;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ---------- loading ---------- */
+
+static void mesh_clear(Mesh *m) {
+    free(m->name);
+    free(m->vert);
+    free(m->face);
+    free(m->fn);
+    free(m->area);
+    free(m->fc);
+    free(m->vn);
+    memset(m, 0, sizeof *m);
+}
+
+static int read_vertices(Mesh *m, const char *fname) {
+    FILE *fp = fopen(fname, "r");
+    if (!fp) { printf("Error: cannot open %s\n", fname); return 0; }
+    size_t cap = 0, bad = 0;
+    char line[256], name[NAME_LEN];
+    double v[3];
+    while (fgets(line, sizeof line, fp)) {
+        if (line[0] == '\n' || line[0] == '\r' || line[0] == '#') continue;
+        if (sscanf(line, "%31[^,],%lf,%lf,%lf", name, &v[0], &v[1], &v[2]) != 4) { bad++; continue; }
+        if (m->nv == cap) {
+            cap = cap ? cap * 2 : 1024;
+            char (*nm)[NAME_LEN] = xrealloc(m->name, cap * sizeof *m->name);
+            if (nm) m->name = nm;
+            double (*vt)[3] = nm ? xrealloc(m->vert, cap * sizeof *m->vert) : NULL;
+            if (!vt) { fclose(fp); return 0; }
+            m->vert = vt;
+        }
+        strcpy(m->name[m->nv], name);
+        memcpy(m->vert[m->nv], v, sizeof v);
+        m->nv++;
+    }
+    fclose(fp);
+    if (bad) printf("Warning: %zu bad vertex lines ignored\n", bad);
+    return 1;
+}
+
+/* Three vertex numbers per line; anything else is an error, since a skipped
+ * face would silently change every vertex normal around it. */
+static int read_faces(Mesh *m, const char *fname) {
+    FILE *fp = fopen(fname, "r");
+    if (!fp) { printf("Error: cannot open %s\n", fname); return 0; }
+    size_t cap = 0, lineno = 0;
+    char line[256];
+    while (fgets(line, sizeof line, fp)) {
+        lineno++;
+        char *p = line, *end;
+        size_t idx[3];
+        int k = 0;
+        for (;;) {
+            while (*p == ' ' || *p == '\t' || *p == ',') p++;
+            if (*p == '\0' || *p == '\n' || *p == '\r' || *p == '#') break;
+            unsigned long long u = strtoull(p, &end, 10);
+            if (end == p || *p == '-' || k == 3) { k = -1; break; }
+            idx[k++] = (size_t)u;
+            if (u >= m->nv) {
+                printf("Error: %s line %zu: vertex %llu out of range (%zu vertices)\n",
+                       fname, lineno, u, m->nv);
+                fclose(fp);
+                return 0;
+            }
+            p = end;
+        }
+        if (k == 0) continue;              /* blank or comment */
+        if (k != 3) {
+            printf("Error: %s line %zu: expected three vertex numbers\n", fname, lineno);
+            fclose(fp);
+            return 0;
+        }
+        if (m->nf == cap) {
+            cap = cap ? cap * 2 : 1024;
+            size_t (*fc)[3] = xrealloc(m->face, cap * sizeof *m->face);
+            if (!fc) { fclose(fp); return 0; }
+            m->face = fc;
+        }
+        memcpy(m->face[m->nf++], idx, sizeof idx);
+    }
+    fclose(fp);
+    return 1;
+}
+
+/* ---------- kernels ---------- */
+
+/* Faces lo..hi: normal n = (b - a) x (c - a), area |n|/2, centroid
+ * (a + b + c)/3. The raw n is added to each corner's sum, which weights
+ * the vertex normals by area. */
+static void *face_main(void *arg) {
+    Work *w = arg;
+    Mesh *m = w->m;
+    double a[TILE][3], b[TILE][3], c[TILE][3], n[TILE][3], len[TILE];
+    for (size_t t = w->lo; t < w->hi; t += TILE) {
+        size_t cnt = w->hi - t < TILE ? w->hi - t : TILE;
+        const size_t (*f)[3] = (const size_t (*)[3])m->face + t;
+        for (size_t k = 0; k < cnt; ++k) {
+            memcpy(a[k], m->vert[f[k][0]], sizeof a[k]);
+            memcpy(b[k], m->vert[f[k][1]], sizeof b[k]);
+            memcpy(c[k], m->vert[f[k][2]], sizeof c[k]);
+            for (int j = 0; j < 3; ++j)
+                m->fc[t + k][j] = (a[k][j] + b[k][j] + c[k][j]) * (1.0 / 3.0);
+        }
+        v_sub_batch((const double (*)[3])b, (const double (*)[3])a, b, cnt);
+        v_sub_batch((const double (*)[3])c, (const double (*)[3])a, c, cnt);
+        v_cross_batch((const double (*)[3])b, (const double (*)[3])c, n, cnt);
+        v_mag_batch((const double (*)[3])n, len, cnt);
+        v_normalize_batch((const double (*)[3])n, m->fn + t, cnt);
+        for (size_t k = 0; k < cnt; ++k) {
+            m->area[t + k] = 0.5 * len[k];
+            w->area += m->area[t + k];
+            if (len[k] == 0.0) w->degenerate++;
+            for (int j = 0; j < 3; ++j) {
+                double *s = w->acc[f[k][j]];
+                s[0] += n[k][0]; s[1] += n[k][1]; s[2] += n[k][2];
+            }
+        }
+    }
+    return NULL;
+}
+
+/* Vertices lo..hi: add the other threads' sums into the first and normalize. */
+static void *vertex_main(void *arg) {
+    Work *w = arg;
+    double (*sum)[3] = w->parts[0];
+    for (int p = 1; p < w->nparts; ++p)
+        for (size_t i = w->lo; i < w->hi; ++i)
+            v_add(sum[i], w->parts[p][i], sum[i]);
+    if (w->hi > w->lo)
+        v_normalize_batch((const double (*)[3])sum + w->lo, w->m->vn + w->lo, w->hi - w->lo);
+    return NULL;
+}
+
+static int pick_threads(size_t n) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t t = n / MIN_PER_THREAD;
+    if (cpus > 0 && t > (size_t)cpus) t = (size_t)cpus;
+    if (t > MAX_THREADS) t = MAX_THREADS;
+    return t ? (int)t : 1;
+}
+
+/* Split n items evenly over work[0..nthreads-1]; the calling thread takes share 0. */
+static void run(Work *work, int nthreads, size_t n, void *(*fn)(void *)) {
+    pthread_t tid[MAX_THREADS];
+    size_t per = (n / (size_t)nthreads + TILE - 1) / TILE * TILE;
+    for (int t = 0; t < nthreads; ++t) {
+        size_t lo = per * (size_t)t, hi = lo + per;
+        if (lo > n) lo = n;
+        if (hi > n || t == nthreads - 1) hi = n;
+        work[t].lo = lo;
+        work[t].hi = hi;
+    }
+    int started = 1;
+    for (int t = 1; t < nthreads; ++t, ++started)
+        if (pthread_create(&tid[t], NULL, fn, &work[t]) != 0) break;
+    for (int t = started; t < nthreads; ++t) fn(&work[t]);   /* could not start: run here */
+    fn(&work[0]);
+    for (int t = 1; t < started; ++t) pthread_join(tid[t], NULL);
+}
+
+/* 0 if memory runs out; the caller then drops m. */
+static int compute(Mesh *m) {
+    if (!(m->fn   = xmalloc(m->nf * sizeof *m->fn))   ||
+        !(m->area = xmalloc(m->nf * sizeof *m->area)) ||
+        !(m->fc   = xmalloc(m->nf * sizeof *m->fc))   ||
+        !(m->vn   = xmalloc(m->nv * sizeof *m->vn)))
+        return 0;
+
+    int nthreads = pick_threads(m->nf);
+    Work work[MAX_THREADS];
+    double (*parts[MAX_THREADS])[3];
+    for (int t = 0; t < nthreads; ++t) {
+        parts[t] = xmalloc(m->nv * sizeof *parts[t]);
+        if (!parts[t]) {
+            while (t--) free(parts[t]);
+            return 0;
+        }
+        memset(parts[t], 0, m->nv * sizeof *parts[t]);
+        work[t] = (Work){ m, 0, 0, parts[t], parts, nthreads, 0.0, 0 };
+    }
+
+    double t0 = now_s();
+    run(work, nthreads, m->nf, face_main);
+    run(work, nthreads, m->nv, vertex_main);
+    m->secs = now_s() - t0;
+    m->threads = nthreads;
+
+    m->total_area = 0.0;
+    m->degenerate = 0;
+    for (int t = 0; t < nthreads; ++t) {
+        m->total_area += work[t].area;
+        m->degenerate += work[t].degenerate;
+        free(parts[t]);
+    }
+    return 1;
+}
+
+/* ---------- commands ---------- */
+
+int mesh_load(const char *vert_file, const char *face_file) {
+    Mesh m;
+    memset(&m, 0, sizeof m);
+    if (!read_vertices(&m, vert_file) || !read_faces(&m, face_file) || !compute(&m)) {
+        mesh_clear(&m);
+        return 0;
+    }
+    mesh_clear(&mesh);
+    mesh = m;
+    have_mesh = 1;
+    mesh_info();
+    return 1;
+}
+
+void mesh_info(void) {
+    if (!have_mesh) { puts("(no mesh; use mesh load <vertices.csv> <faces>)"); return; }
+    printf("mesh: %zu vertices, %zu faces, area %.6f", mesh.nv, mesh.nf, mesh.total_area);
+    if (mesh.degenerate) printf(", %zu degenerate", mesh.degenerate);
+    printf(" (%d thread%s, %.3f s)\n", mesh.threads, mesh.threads == 1 ? "" : "s", mesh.secs);
+}
+
+void mesh_free(void) {
+    mesh_clear(&mesh);
+    have_mesh = 0;
+}
+
+int mesh_save(const char *what, const char *fname) {
+    if (!have_mesh) { puts("Error: no mesh loaded."); return 0; }
+    int faces = strcmp(what, "faces") == 0;
+    if (!faces && strcmp(what, "normals") != 0) {
+        puts("Error: mesh save needs faces or normals.");
+        return 0;
+    }
+    FILE *fp = fopen(fname, "w");
+    if (!fp) { printf("Error: cannot open %s\n", fname); return 0; }
+    if (faces) {
+        fputs("face,nx,ny,nz,area,cx,cy,cz\n", fp);
+        for (size_t i = 0; i < mesh.nf; ++i)
+            fprintf(fp, "%zu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n", i,
+                    mesh.fn[i][0], mesh.fn[i][1], mesh.fn[i][2], mesh.area[i],
+                    mesh.fc[i][0], mesh.fc[i][1], mesh.fc[i][2]);
+    } else {
+        for (size_t i = 0; i < mesh.nv; ++i)
+            fprintf(fp, "%s,%.6f,%.6f,%.6f\n", mesh.name[i],
+                    mesh.vn[i][0], mesh.vn[i][1], mesh.vn[i][2]);
+    }
+    fclose(fp);
+    printf("Saved %zu %s to %s\n", faces ? mesh.nf : mesh.nv,
+           faces ? "faces" : "vertex normals", fname);
+    return 1;
+}
@@ -0,0 +1,23 @@
+/* Filename: vector_mesh.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Triangle meshes. An indexed triangle list (vertex CSV plus a
+ *              face index file) is loaded outside the store; face normals,
+ *              areas, centroids and area-weighted vertex normals are computed
+ *              in batches on several threads and written out as CSV.
+ */
+#ifndef VECTOR_MESH_H
+#define VECTOR_MESH_H
+
+/* Vertices are name,x,y,z rows numbered from 0 in file order; each face line
+ * holds three vertex numbers (space or comma separated, '#' starts a comment).
+ * Replaces any loaded mesh and computes everything at once. */
+int  mesh_load(const char *vert_file, const char *face_file);
+void mesh_info(void);
+void mesh_free(void);
+
+/* what = "faces": face,nx,ny,nz,area,cx,cy,cz with a header line.
+ * what = "normals": name,x,y,z per vertex, loadable with load/merge. */
+int  mesh_save(const char *what, const char *fname);
+
+#endif /* VECTOR_MESH_H */
@@ -0,0 +1,289 @@
+/* Filename: vector_particles.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Particle integration. The set is gathered from the store into
+ *              one array per coordinate (x, y, z of position, velocity and
+ *              force), advanced by a fused SSE2 kernel on several threads,
+ *              and written back when the run ends.
+ */
+#define _POSIX_C_SOURCE 200809L   /* sysconf, clock_gettime */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "vector_update.h"
+#include "vector_particles.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MAX_THREADS    16
+#define MIN_PER_THREAD 8192   /* smaller shares cost more to start than they save */
+#define TILE           512    /* particles taken through a whole block of steps at once */
+
+static char pos_pfx[NAME_LEN], vel_pfx[NAME_LEN], frc_pfx[NAME_LEN];
+static int  have_set = 0;
+
+typedef struct {
+    size_t  n;
+    size_t *pslot, *vslot;     /* store slots, for write-back and names */
+    double *x[3], *v[3];
+    double *a[3];              /* all NULL when the set has no forces */
+    double *mem;
+} Set;
+
+typedef struct {
+    Set   *set;
+    size_t lo, hi;
+    double dt;
+    long   steps;
+    int    method;
+} Work;
+
+/* NULL (and the message) when memory runs out; the command then fails. */
+static void *xmalloc(size_t n) {
+    void *p = malloc(n ? n : 1);
+    if (!p) puts("Error: out of memory.");
+    return p;
+}
+
+/* ---------- gather / write-back ---------- */
+
+static void set_free(Set *s) {
+    free(s->pslot);
+    free(s->vslot);
+    free(s->mem);
+}
+
+/* Pair every p<suffix> with v<suffix> (and f<suffix>; missing forces are
+ * zero) into s, s->n particles; *no_vel counts positions skipped.
+ * Returns 0, with nothing left to free, if memory runs out. */
+static int gather(Set *s, size_t *no_vel) {
+    size_t size = store_size(), plen = strlen(pos_pfx), n = 0;
+    int forces = frc_pfx[0] != '\0';
+    memset(s, 0, sizeof *s);
+    long *fslot = NULL;
+    if (!(s->pslot = (size_t*)xmalloc(size * sizeof *s->pslot)) ||
+        !(s->vslot = (size_t*)xmalloc(size * sizeof *s->vslot)) ||
+        (forces && !(fslot = (long*)xmalloc(size * sizeof *fslot)))) {
+        set_free(s);
+        return 0;
+    }
+    *no_vel = 0;
+
+    char name[2 * NAME_LEN];
+    for (size_t i = 0; i < size; ++i) {
+        const Vec *e = store_at(i);
+        if (!e->used || strncmp(e->name, pos_pfx, plen) != 0) continue;
+        const char *suffix = e->name + plen;
+        snprintf(name, sizeof name, "%s%s", vel_pfx, suffix);
+        long vs = strlen(name) < NAME_LEN ? store_find(name) : -1;
+        if (vs < 0) { ++*no_vel; continue; }
+        s->pslot[n] = i;
+        s->vslot[n] = (size_t)vs;
+        if (forces) {
+            snprintf(name, sizeof name, "%s%s", frc_pfx, suffix);
+            fslot[n] = strlen(name) < NAME_LEN ? store_find(name) : -1;
+        }
+        n++;
+    }
+
+    s->n = n;
+    s->mem = (double*)xmalloc((forces ? 9 : 6) * (n ? n : 1) * sizeof *s->mem);
+    if (!s->mem) {
+        free(fslot);
+        set_free(s);
+        return 0;
+    }
+    for (int c = 0; c < 3; ++c) {
+        s->x[c] = s->mem + (size_t)c * n;
+        s->v[c] = s->mem + (size_t)(3 + c) * n;
+        if (forces) s->a[c] = s->mem + (size_t)(6 + c) * n;
+    }
+    for (size_t k = 0; k < n; ++k) {
+        const double *p = store_at(s->pslot[k])->v, *v = store_at(s->vslot[k])->v;
+        for (int c = 0; c < 3; ++c) { s->x[c][k] = p[c]; s->v[c][k] = v[c]; }
+        if (forces) {
+            const double *f = fslot[k] >= 0 ? store_at((size_t)fslot[k])->v : NULL;
+            for (int c = 0; c < 3; ++c) s->a[c][k] = f ? f[c] : 0.0;
+        }
+    }
+    free(fslot);
+    return 1;
+}
+
+/* 0 if the store ran out of memory part way (it has printed why). */
+static int write_back(const Set *s) {
+    for (size_t k = 0; k < s->n; ++k) {
+        double p[3] = { s->x[0][k], s->x[1][k], s->x[2][k] };
+        if (!store_set_at(s->pslot[k], p)) return 0;
+        if (s->a[0]) {                       /* velocities only change under a force */
+            double v[3] = { s->v[0][k], s->v[1][k], s->v[2][k] };
+            if (!store_set_at(s->vslot[k], v)) return 0;
+        }
+    }
+    return 1;
+}
+
+static void write_frame(FILE *fp, const Set *s, long step) {
+    for (size_t k = 0; k < s->n; ++k)
+        fprintf(fp, "%ld,%s,%.6f,%.6f,%.6f\n", step, store_at(s->pslot[k])->name,
+                s->x[0][k], s->x[1][k], s->x[2][k]);
+    fflush(fp);
+}
+
+/* ---------- kernel ---------- */
+
+/* One coordinate of n particles, `steps` steps. Euler: x += v dt, then
+ * v += a dt. Velocity Verlet with a constant a reduces to
+ * x += v dt + a dt^2/2, v += a dt. Both update x and v in one pass. */
+static void advance(double *x, double *v, const double *a, size_t n,
+                    double dt, long steps, int method) {
+    double h = method == INTEG_VERLET ? 0.5 * dt * dt : 0.0;
+    for (long s = 0; s < steps; ++s) {
+        size_t i = 0;
+#if defined(__SSE2__)
+        const __m128d vdt = _mm_set1_pd(dt), vh = _mm_set1_pd(h);
+        if (a) {
+            for (; i + 2 <= n; i += 2) {
+                __m128d xv = _mm_loadu_pd(x + i), vv = _mm_loadu_pd(v + i), av = _mm_loadu_pd(a + i);
+                xv = _mm_add_pd(xv, _mm_add_pd(_mm_mul_pd(vv, vdt), _mm_mul_pd(av, vh)));
+                vv = _mm_add_pd(vv, _mm_mul_pd(av, vdt));
+                _mm_storeu_pd(x + i, xv);
+                _mm_storeu_pd(v + i, vv);
+            }
+        } else {
+            for (; i + 2 <= n; i += 2)
+                _mm_storeu_pd(x + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_mul_pd(_mm_loadu_pd(v + i), vdt)));
+        }
+#endif
+        for (; i < n; ++i) {
+            if (a) { x[i] += v[i] * dt + a[i] * h; v[i] += a[i] * dt; }
+            else     x[i] += v[i] * dt;
+        }
+    }
+}
+
+/* Particles never interact, so each tile runs the whole block of steps
+ * while it is still in L1 before moving on. */
+static void *work_main(void *arg) {
+    Work *w = arg;
+    Set *s = w->set;
+    for (size_t t = w->lo; t < w->hi; t += TILE) {
+        size_t len = w->hi - t < TILE ? w->hi - t : TILE;
+        for (int c = 0; c < 3; ++c)
+            advance(s->x[c] + t, s->v[c] + t, s->a[c] ? s->a[c] + t : NULL, len,
+                    w->dt, w->steps, w->method);
+    }
+    return NULL;
+}
+
+static int pick_threads(size_t n) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t t = n / MIN_PER_THREAD;
+    if (cpus > 0 && t > (size_t)cpus) t = (size_t)cpus;
+    if (t > MAX_THREADS) t = MAX_THREADS;
+    return t ? (int)t : 1;
+}
+
+/* Split the set evenly (tile-aligned); the calling thread takes share 0. */
+static void run_block(Set *s, int nthreads, double dt, long steps, int method) {
+    Work work[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    size_t per = (s->n / (size_t)nthreads + TILE - 1) / TILE * TILE;
+    for (int t = 0; t < nthreads; ++t) {
+        size_t lo = per * (size_t)t, hi = lo + per;
+        if (lo > s->n) lo = s->n;
+        if (hi > s->n || t == nthreads - 1) hi = s->n;
+        work[t] = (Work){ s, lo, hi, dt, steps, method };
+    }
+    int started = 1;
+    for (int t = 1; t < nthreads; ++t, ++started)
+        if (pthread_create(&tid[t], NULL, work_main, &work[t]) != 0) break;
+    for (int t = started; t < nthreads; ++t) work_main(&work[t]);   /* could not start: run here */
+    work_main(&work[0]);
+    for (int t = 1; t < started; ++t) pthread_join(tid[t], NULL);
+}
+
+/* ---------- commands ---------- */
+
+int particles_define(const char *pos_prefix, const char *vel_prefix, const char *force_prefix) {
+    if (!*pos_prefix || !*vel_prefix || strcmp(pos_prefix, vel_prefix) == 0 ||
+        strlen(pos_prefix) >= NAME_LEN || strlen(vel_prefix) >= NAME_LEN ||
+        (force_prefix && strlen(force_prefix) >= NAME_LEN)) {
+        puts("Error: particles needs two different prefixes (and an optional third for forces).");
+        return 0;
+    }
+    strcpy(pos_pfx, pos_prefix);
+    strcpy(vel_pfx, vel_prefix);
+    strcpy(frc_pfx, force_prefix ? force_prefix : "");
+    have_set = 1;
+    particles_info();
+    return 1;
+}
+
+void particles_info(void) {
+    if (!have_set) { puts("(no particle set; use particles <pos> <vel> [force])"); return; }
+    Set s;
+    size_t no_vel;
+    if (!gather(&s, &no_vel)) return;
+    printf("particles: %zu (%s* with %s*", s.n, pos_pfx, vel_pfx);
+    if (frc_pfx[0]) printf(", forces %s*", frc_pfx);
+    printf(")");
+    if (no_vel) printf(", %zu %s* without a velocity ignored", no_vel, pos_pfx);
+    putchar('\n');
+    set_free(&s);
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int particles_step(double dt, long nsteps, int method, long snap_every, const char *snap_file) {
+    if (!have_set) { puts("Error: no particle set (use particles <pos> <vel> [force])."); return 0; }
+
+    FILE *fp = NULL;
+    if (snap_every > 0) {
+        fp = fopen(snap_file, "w");
+        if (!fp) { printf("Error: cannot open %s\n", snap_file); return 0; }
+        fputs("step,name,x,y,z\n", fp);
+    }
+
+    Set s;
+    size_t no_vel;
+    if (!gather(&s, &no_vel)) {
+        if (fp) fclose(fp);
+        return 0;
+    }
+    int nthreads = pick_threads(s.n);
+    double t0 = now_s();
+
+    if (fp) write_frame(fp, &s, 0);
+    for (long done = 0; done < nsteps; ) {
+        long block = nsteps - done;
+        if (fp && block > snap_every) block = snap_every;
+        run_block(&s, nthreads, dt, block, method);
+        done += block;
+        if (fp && done % snap_every == 0) write_frame(fp, &s, done);
+    }
+    int ok = write_back(&s);
+
+    if (ok)
+        printf("stepped %zu particles x %ld steps (%s, dt %g, %d thread%s) in %.3f s\n",
+               s.n, nsteps, method == INTEG_VERLET ? "verlet" : "euler", dt,
+               nthreads, nthreads == 1 ? "" : "s", now_s() - t0);
+    else
+        puts("Error: step results were only partly written back.");
+    if (fp) {
+        fclose(fp);
+        printf("snapshots every %ld steps written to %s\n", snap_every, snap_file);
+    }
+    set_free(&s);
+    return ok;
+}
@@ -0,0 +1,23 @@
+/* Filename: vector_particles.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Particle sets over the store. Positions, velocities and
+ *              (optionally) forces are paired by name suffix, e.g. p17/v17/f17,
+ *              gathered into contiguous x/y/z arrays and integrated there by
+ *              several threads; results are written back to the store.
+ */
+#ifndef VECTOR_PARTICLES_H
+#define VECTOR_PARTICLES_H
+
+enum { INTEG_EULER, INTEG_VERLET };
+
+/* force_prefix may be NULL (no forces). Prints how many particles matched. */
+int  particles_define(const char *pos_prefix, const char *vel_prefix, const char *force_prefix);
+void particles_info(void);
+
+/* Advance every particle nsteps steps of dt. Forces are per unit mass and
+ * held constant over the run. snap_every > 0 streams positions to
+ * snap_file (step,name,x,y,z) at step 0 and every snap_every steps. */
+int  particles_step(double dt, long nsteps, int method, long snap_every, const char *snap_file);
+
+#endif /* VECTOR_PARTICLES_H */
@@ -0,0 +1,191 @@
+/* Filename: vector_query.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Sorting and top-k over the store. Doubles are mapped to
+ *              order-preserving 64-bit keys and LSD radix sorted; top-k uses
+ *              quickselect so only the k winners get sorted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "vector_update.h"
+#include "vector_query.h"
+
+typedef struct {
+    uint64_t key;
+    size_t   idx;
+} Item;
+
+static SortKey cur_key;   /* for the qsort comparator */
+
+int parse_sort_key(const char *s, SortKey *key) {
+    if      (strcmp(s, "mag")  == 0) *key = KEY_MAG;
+    else if (strcmp(s, "x")    == 0) *key = KEY_X;
+    else if (strcmp(s, "y")    == 0) *key = KEY_Y;
+    else if (strcmp(s, "z")    == 0) *key = KEY_Z;
+    else if (strcmp(s, "name") == 0) *key = KEY_NAME;
+    else return 0;
+    return 1;
+}
+
+/* ---------- keys ---------- */
+
+/* Flip so that unsigned order == numeric order (negatives reversed). */
+static uint64_t double_key(double d) {
+    uint64_t u;
+    memcpy(&u, &d, sizeof u);
+    return (u & 0x8000000000000000ull) ? ~u : (u | 0x8000000000000000ull);
+}
+
+/* First 8 bytes of the name, big-endian; ties are settled with strcmp. */
+static uint64_t name_key(const char *s) {
+    uint64_t k = 0;
+    int i = 0;
+    for (; i < 8 && s[i]; ++i) k = (k << 8) | (unsigned char)s[i];
+    return k << (8 * (8 - i));
+}
+
+static uint64_t item_key(const Vec *e, SortKey key) {
+    switch (key) {
+        case KEY_MAG:  return 0;    /* taken from the magnitude cache in gather */
+        case KEY_X:    return double_key(e->v[0]);
+        case KEY_Y:    return double_key(e->v[1]);
+        case KEY_Z:    return double_key(e->v[2]);
+        case KEY_NAME: return name_key(e->name);
+    }
+    return 0;
+}
+
+/* Collect used slots; desc inverts keys so everything sorts ascending.
+ * Magnitudes come in one batch, or slot by slot if that buffer won't fit. */
+static size_t gather(SortKey key, int desc, Item *items) {
+    size_t n = 0, size = store_size();
+    double *mag = NULL;
+    if (key == KEY_MAG && (mag = (double*)malloc((size ? size : 1) * sizeof *mag)) != NULL)
+        store_mags(mag);
+    for (size_t i = 0; i < size; ++i) {
+        const Vec *e = store_at(i);
+        if (!e->used) continue;
+        uint64_t k = key != KEY_MAG ? item_key(e, key) : double_key(mag ? mag[i] : store_mag(i));
+        items[n].key = desc ? ~k : k;
+        items[n].idx = i;
+        n++;
+    }
+    free(mag);
+    return n;
+}
+
+static int name_cmp(size_t a, size_t b) {
+    return strcmp(store_at(a)->name, store_at(b)->name);
+}
+
+/* Total order: key, then full name for name sorts, then insertion order. */
+static int item_cmp(const Item *a, const Item *b, int desc) {
+    if (a->key != b->key) return a->key < b->key ? -1 : 1;
+    if (cur_key == KEY_NAME) {
+        int c = name_cmp(a->idx, b->idx);
+        if (c) return desc ? -c : c;
+    }
+    return (a->idx > b->idx) - (a->idx < b->idx);
+}
+
+static int cmp_asc(const void *a, const void *b)  { return item_cmp(a, b, 0); }
+static int cmp_desc(const void *a, const void *b) { return item_cmp(a, b, 1); }
+
+/* ---------- radix sort ---------- */
+
+/* Stable LSD radix sort on the 64-bit key, 8 bits per pass.
+ * Passes where every key has the same byte are skipped.
+ * Returns 0 if there is no memory for the scratch copy. */
+static int radix_sort(Item *a, size_t n) {
+    Item *tmp = (Item*)malloc(n * sizeof *tmp);
+    if (!tmp) return 0;
+
+    size_t count[8][256] = {{0}};
+    for (size_t i = 0; i < n; ++i)
+        for (int p = 0; p < 8; ++p) count[p][(a[i].key >> (8 * p)) & 0xff]++;
+
+    Item *src = a, *dst = tmp;
+    for (int p = 0; p < 8; ++p) {
+        size_t *c = count[p];
+        if (c[(src[0].key >> (8 * p)) & 0xff] == n) continue;
+        size_t sum = 0;
+        for (int b = 0; b < 256; ++b) { size_t t = c[b]; c[b] = sum; sum += t; }
+        for (size_t i = 0; i < n; ++i) dst[c[(src[i].key >> (8 * p)) & 0xff]++] = src[i];
+        Item *t = src; src = dst; dst = t;
+    }
+    if (src != a) memcpy(a, src, n * sizeof *a);
+    free(tmp);
+    return 1;
+}
+
+/* Runs with equal 8-byte name prefixes still need a full strcmp. */
+static void fix_name_ties(Item *a, size_t n, int desc) {
+    for (size_t i = 0; i < n; ) {
+        size_t j = i + 1;
+        while (j < n && a[j].key == a[i].key) ++j;
+        if (j - i > 1) qsort(a + i, j - i, sizeof *a, desc ? cmp_desc : cmp_asc);
+        i = j;
+    }
+}
+
+size_t order_by(SortKey key, int desc, size_t *out) {
+    size_t size = store_size();
+    if (!size) return 0;
+    Item *items = (Item*)malloc(size * sizeof *items);
+    if (!items) { puts("Error: out of memory."); return VL_ERROR; }
+
+    cur_key = key;
+    size_t n = gather(key, desc, items);
+    if (n && !radix_sort(items, n))
+        qsort(items, n, sizeof *items, desc ? cmp_desc : cmp_asc);   /* same order, in place */
+    else if (key == KEY_NAME) fix_name_ties(items, n, desc);
+
+    for (size_t i = 0; i < n; ++i) out[i] = items[i].idx;
+    free(items);
+    return n;
+}
+
+/* ---------- top-k ---------- */
+
+static void swap_items(Item *a, Item *b) { Item t = *a; *a = *b; *b = t; }
+
+/* Quickselect: afterwards a[0..k-1] hold the k smallest items (unordered). */
+static void select_k(Item *a, size_t n, size_t k, int desc) {
+    size_t lo = 0, hi = n - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        /* median of three into a[hi] as pivot */
+        if (item_cmp(&a[mid], &a[lo], desc) < 0) swap_items(&a[mid], &a[lo]);
+        if (item_cmp(&a[hi],  &a[lo], desc) < 0) swap_items(&a[hi],  &a[lo]);
+        if (item_cmp(&a[mid], &a[hi], desc) < 0) swap_items(&a[mid], &a[hi]);
+
+        size_t store = lo;
+        for (size_t i = lo; i < hi; ++i)
+            if (item_cmp(&a[i], &a[hi], desc) < 0) swap_items(&a[i], &a[store++]);
+        swap_items(&a[store], &a[hi]);
+
+        if (store == k - 1 || store == k) return;
+        if (store < k) lo = store + 1;
+        else           hi = store - 1;
+    }
+}
+
+size_t top_k(SortKey key, int desc, size_t k, size_t *out) {
+    size_t size = store_size();
+    if (!size || !k) return 0;
+    Item *items = (Item*)malloc(size * sizeof *items);
+    if (!items) { puts("Error: out of memory."); return VL_ERROR; }
+
+    cur_key = key;
+    size_t n = gather(key, desc, items);
+    if (k > n) k = n;
+    if (k < n) select_k(items, n, k, desc);
+    qsort(items, k, sizeof *items, desc ? cmp_desc : cmp_asc);
+
+    for (size_t i = 0; i < k; ++i) out[i] = items[i].idx;
+    free(items);
+    return k;
+}
@@ -0,0 +1,25 @@
+/* Filename: vector_query.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Ordered views over the store (full sort and top-k).
+ */
+#ifndef VECTOR_QUERY_H
+#define VECTOR_QUERY_H
+
+#include <stddef.h>
+
+typedef enum { KEY_MAG, KEY_X, KEY_Y, KEY_Z, KEY_NAME } SortKey;
+
+/* "mag", "x", "y", "z" or "name"; returns 0 if unknown. */
+int parse_sort_key(const char *s, SortKey *key);
+
+/* Fill out[] with every used slot in key order (stable: ties keep
+ * insertion order). out needs store_size() entries. Returns the count, or
+ * VL_ERROR after printing "Error: out of memory.". */
+size_t order_by(SortKey key, int desc, size_t *out);
+
+/* Fill out[] with the first k slots in key order without sorting the rest.
+ * out needs k entries. Returns the count (<= k), or VL_ERROR as above. */
+size_t top_k(SortKey key, int desc, size_t k, size_t *out);
+
+#endif /* VECTOR_QUERY_H */
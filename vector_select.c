@@ -0,0 +1,395 @@
+/* Filename: vector_select.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Predicate evaluation into selection bitmaps. Needed fields are
+ *              gathered into contiguous columns and compared two doubles at a
+ *              time (SSE2), 64 results packed per bitmap word.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include "vector_update.h"
+#include "vector_select.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MAX_TOKENS 64
+
+typedef struct {
+    char     name[NAME_LEN];
+    uint64_t *bits;
+    size_t   nbits;       /* store_size() when evaluated */
+    size_t   count;
+    unsigned long epoch;  /* store_epoch() when evaluated */
+} Selection;
+
+static Selection *sels = NULL;
+static size_t nsels = 0, capsels = 0;
+
+enum { F_X, F_Y, F_Z, F_MAG, F_NAME };
+enum { OP_LT, OP_LE, OP_GT, OP_GE, OP_EQ, OP_NE, OP_PREFIX };
+
+typedef struct {
+    int         field;
+    int         op;
+    double      num;
+    const char *str;
+    int         or_next;  /* 1 if "or" follows this condition */
+} Cond;
+
+/* NULL (and the message) when memory runs out; the command then fails. */
+static void *xcalloc(size_t n, size_t sz) {
+    void *p = calloc(n ? n : 1, sz);
+    if (!p) puts("Error: out of memory.");
+    return p;
+}
+
+static size_t words_for(size_t nbits) { return (nbits + 63) / 64; }
+
+static size_t popcount_bits(const uint64_t *bits, size_t words) {
+    size_t c = 0;
+    for (size_t w = 0; w < words; ++w) c += (size_t)__builtin_popcountll(bits[w]);
+    return c;
+}
+
+/* ---------- predicate parsing ---------- */
+
+static int parse_field(const char *s) {
+    if (strcmp(s, "x") == 0)    return F_X;
+    if (strcmp(s, "y") == 0)    return F_Y;
+    if (strcmp(s, "z") == 0)    return F_Z;
+    if (strcmp(s, "mag") == 0)  return F_MAG;
+    if (strcmp(s, "name") == 0) return F_NAME;
+    return -1;
+}
+
+static int parse_op(const char *s) {
+    if (strcmp(s, "<") == 0)  return OP_LT;
+    if (strcmp(s, "<=") == 0) return OP_LE;
+    if (strcmp(s, ">") == 0)  return OP_GT;
+    if (strcmp(s, ">=") == 0) return OP_GE;
+    if (strcmp(s, "==") == 0) return OP_EQ;
+    if (strcmp(s, "!=") == 0) return OP_NE;
+    if (strcmp(s, "^=") == 0) return OP_PREFIX;
+    return -1;
+}
+
+/* Split buf in place on whitespace. */
+static int tokenize(char *buf, char **tok, int max) {
+    int n = 0;
+    char *p = buf;
+    while (*p && n < max) {
+        while (isspace((unsigned char)*p)) *p++ = '\0';
+        if (!*p) break;
+        tok[n++] = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+    }
+    return n;
+}
+
+/* Returns the number of conditions, or -1 on a syntax error. */
+static int parse_pred(char *buf, Cond *conds, int max) {
+    char *tok[MAX_TOKENS];
+    int nt = tokenize(buf, tok, MAX_TOKENS), nc = 0;
+    for (int i = 0; i < nt; ) {
+        if (nc == max || i + 3 > nt) return -1;
+        Cond *c = &conds[nc++];
+        c->field = parse_field(tok[i]);
+        c->op = parse_op(tok[i + 1]);
+        c->or_next = 0;
+        if (c->field < 0 || c->op < 0) return -1;
+        if (c->field == F_NAME) {
+            if (c->op != OP_EQ && c->op != OP_NE && c->op != OP_PREFIX) return -1;
+            c->str = tok[i + 2];
+        } else {
+            char *end = NULL;
+            if (c->op == OP_PREFIX) return -1;
+            c->num = strtod(tok[i + 2], &end);
+            if (!end || *end) return -1;
+        }
+        i += 3;
+        if (i == nt) break;
+        if (strcmp(tok[i], "or") == 0) c->or_next = 1;
+        else if (strcmp(tok[i], "and") != 0) return -1;
+        if (++i == nt) return -1;
+    }
+    return nc;
+}
+
+/* ---------- column compare ---------- */
+
+#if defined(__SSE2__)
+#define CMP_LOOP(VOP, SOP)                                                    \
+    do {                                                                      \
+        __m128d cv = _mm_set1_pd(c);                                          \
+        for (size_t w = 0; w < words; ++w) {                                  \
+            const double *p = col + w * 64;                                   \
+            uint64_t m = 0;                                                   \
+            for (int k = 0; k < 64; k += 2)                                   \
+                m |= (uint64_t)_mm_movemask_pd(VOP(_mm_loadu_pd(p + k), cv)) << k; \
+            out[w] = m;                                                       \
+        }                                                                     \
+    } while (0)
+#else
+#define CMP_LOOP(VOP, SOP)                                                    \
+    do {                                                                      \
+        for (size_t w = 0; w < words; ++w) {                                  \
+            const double *p = col + w * 64;                                   \
+            uint64_t m = 0;                                                   \
+            for (int k = 0; k < 64; ++k) m |= (uint64_t)(p[k] SOP c) << k;   \
+            out[w] = m;                                                       \
+        }                                                                     \
+    } while (0)
+#endif
+
+/* col holds words*64 doubles (padding is masked off by the caller). */
+static void cmp_column(const double *col, size_t words, int op, double c, uint64_t *out) {
+    switch (op) {
+        case OP_LT: CMP_LOOP(_mm_cmplt_pd,  <);  break;
+        case OP_LE: CMP_LOOP(_mm_cmple_pd,  <=); break;
+        case OP_GT: CMP_LOOP(_mm_cmpgt_pd,  >);  break;
+        case OP_GE: CMP_LOOP(_mm_cmpge_pd,  >=); break;
+        case OP_EQ: CMP_LOOP(_mm_cmpeq_pd,  ==); break;
+        case OP_NE: CMP_LOOP(_mm_cmpneq_pd, !=); break;
+    }
+}
+
+static void cmp_names(size_t n, const Cond *c, uint64_t *out) {
+    size_t plen = strlen(c->str);
+    memset(out, 0, words_for(n) * sizeof *out);
+    for (size_t i = 0; i < n; ++i) {
+        const char *nm = store_at(i)->name;
+        int hit = c->op == OP_PREFIX ? strncmp(nm, c->str, plen) == 0
+                                     : (strcmp(nm, c->str) == 0) == (c->op == OP_EQ);
+        if (hit) out[i >> 6] |= 1ull << (i & 63);
+    }
+}
+
+/* ---------- evaluation ---------- */
+
+/* Evaluate conds over the current store into a fresh bitmap of n bits
+ * (NULL if memory runs out). */
+static uint64_t *eval_pred(const Cond *conds, int nc, size_t n) {
+    size_t words = words_for(n), padded = words * 64;
+    int need[4] = {0};
+    for (int i = 0; i < nc; ++i) if (conds[i].field != F_NAME) need[conds[i].field] = 1;
+
+    /* Gather only the columns the predicate touches, plus a used mask. */
+    double *col[4] = {NULL};
+    uint64_t *valid = NULL, *result = NULL, *group = NULL, *tmp = NULL;
+    int ok = 1;
+    for (int f = 0; f < 4 && ok; ++f) if (need[f]) ok = (col[f] = xcalloc(padded, sizeof(double))) != NULL;
+    if (ok) ok = (valid  = xcalloc(words, sizeof *valid))  != NULL;
+    if (ok) ok = (result = xcalloc(words, sizeof *result)) != NULL;
+    if (ok) ok = (group  = xcalloc(words, sizeof *group))  != NULL;
+    if (ok) ok = (tmp    = xcalloc(words, sizeof *tmp))    != NULL;
+    if (!ok) {
+        for (int f = 0; f < 4; ++f) free(col[f]);
+        free(valid); free(result); free(group); free(tmp);
+        return NULL;
+    }
+
+    if (col[F_MAG]) store_mags(col[F_MAG]);
+    for (size_t i = 0; i < n; ++i) {
+        const Vec *e = store_at(i);
+        if (!e->used) continue;
+        valid[i >> 6] |= 1ull << (i & 63);
+        for (int f = 0; f < 3; ++f) if (col[f]) col[f][i] = e->v[f];
+    }
+
+    int fresh = 1;
+    for (int i = 0; i < nc; ++i) {
+        const Cond *c = &conds[i];
+        if (c->field == F_NAME) cmp_names(n, c, tmp);
+        else cmp_column(col[c->field], words, c->op, c->num, tmp);
+
+        for (size_t w = 0; w < words; ++w) group[w] = fresh ? tmp[w] : (group[w] & tmp[w]);
+        fresh = 0;
+        if (c->or_next || i == nc - 1) {
+            for (size_t w = 0; w < words; ++w) result[w] |= group[w];
+            fresh = 1;
+        }
+    }
+    for (size_t w = 0; w < words; ++w) result[w] &= valid[w];
+
+    for (int f = 0; f < 4; ++f) free(col[f]);
+    free(valid); free(group); free(tmp);
+    return result;
+}
+
+/* ---------- table ---------- */
+
+static Selection *find_sel(const char *name) {
+    for (size_t i = 0; i < nsels; ++i)
+        if (strcmp(sels[i].name, name) == 0) return &sels[i];
+    return NULL;
+}
+
+/* "@name" -> selection that still matches the store, or NULL + message. */
+static const Selection *resolve(const char *ref) {
+    if (!ref || ref[0] != '@') { puts("Error: selections are referenced as @name."); return NULL; }
+    const Selection *s = find_sel(ref + 1);
+    if (!s) { printf("Error: no selection named %s\n", ref + 1); return NULL; }
+    if (s->epoch != store_epoch()) {
+        printf("Error: selection %s is stale (store was cleared, sorted or deleted from); run select again.\n", s->name);
+        return NULL;
+    }
+    return s;
+}
+
+int sel_define(const char *name, const char *pred) {
+    if (!*name || strlen(name) >= NAME_LEN) { puts("Error: invalid selection name."); return 0; }
+
+    size_t len = strlen(pred);
+    char *buf = xcalloc(len + 1, 1);
+    if (!buf) return 0;
+    memcpy(buf, pred, len);
+    Cond conds[MAX_TOKENS / 4 + 1];
+    int nc = parse_pred(buf, conds, MAX_TOKENS / 4 + 1);
+    if (nc <= 0) {
+        puts("Error: syntax: select <name> where <field> <op> <value> [and|or ...]");
+        puts("       fields x y z mag (< <= > >= == !=), name (== != ^=)");
+        free(buf);
+        return 0;
+    }
+
+    size_t n = store_size();
+    uint64_t *bits = eval_pred(conds, nc, n);
+    free(buf);
+    if (!bits) return 0;
+
+    Selection *s = find_sel(name);
+    if (!s) {
+        if (nsels == capsels) {
+            size_t newcap = capsels ? capsels * 2 : 4;
+            Selection *t = (Selection*)realloc(sels, newcap * sizeof *t);
+            if (!t) { puts("Error: out of memory."); free(bits); return 0; }
+            sels = t;
+            capsels = newcap;
+        }
+        s = &sels[nsels++];
+        strcpy(s->name, name);
+    } else {
+        free(s->bits);
+    }
+    s->bits = bits;
+    s->nbits = n;
+    s->epoch = store_epoch();
+    s->count = popcount_bits(bits, words_for(n));
+    printf("%s: %zu of %zu vectors\n", s->name, s->count, n);
+    return 1;
+}
+
+void sel_list(void) {
+    if (!nsels) { puts("(no selections)"); return; }
+    for (size_t i = 0; i < nsels; ++i)
+        printf("@%s  %zu vectors%s\n", sels[i].name, sels[i].count,
+               sels[i].epoch == store_epoch() ? "" : "  (stale)");
+}
+
+int sel_drop(const char *name) {
+    Selection *s = find_sel(name[0] == '@' ? name + 1 : name);
+    if (!s) { puts("Error: no such selection."); return 0; }
+    free(s->bits);
+    *s = sels[--nsels];
+    return 1;
+}
+
+void sel_free_all(void) {
+    for (size_t i = 0; i < nsels; ++i) free(sels[i].bits);
+    free(sels);
+    sels = NULL;
+    nsels = capsels = 0;
+}
+
+/* ---------- operations on selections ---------- */
+
+#define FOR_EACH_BIT(s, i)                                                    \
+    for (size_t w_ = 0; w_ < words_for((s)->nbits); ++w_)                     \
+        for (uint64_t m_ = (s)->bits[w_]; m_; m_ &= m_ - 1)                   \
+            for (size_t i = w_ * 64 + (size_t)__builtin_ctzll(m_), o_ = 1; o_; o_ = 0)
+
+int sel_apply(const char *ref, char op, const char *operand) {
+    const Selection *s = resolve(ref);
+    if (!s) return 0;
+
+    double b[3] = {0, 0, 0}, k = 0.0;
+    if (op == '*') {
+        char *end = NULL;
+        k = strtod(operand, &end);
+        if (!end || end == operand || *end) { puts("Error: apply @sel * <number>"); return 0; }
+    } else if (!get_vector(operand, b)) {
+        puts("Error: vector operand not found.");
+        return 0;
+    }
+
+    size_t done = 0;
+    FOR_EACH_BIT(s, i) {
+        double r[3];
+        const double *a = store_at(i)->v;
+        if (op == '+')      v_add(a, b, r);
+        else if (op == '-') v_sub(a, b, r);
+        else                v_scale(a, k, r);
+        if (!store_set_at(i, r)) {
+            printf("updated %zu of %zu vectors in @%s\n", done, s->count, s->name);
+            return 0;
+        }
+        done++;
+    }
+    printf("updated %zu vectors in @%s\n", s->count, s->name);
+    return 1;
+}
+
+int sel_stats(const char *ref) {
+    const Selection *s = NULL;
+    if (ref && !(s = resolve(ref))) return 0;
+
+    size_t n = 0;
+    double lo[4], hi[4], sum[4] = {0, 0, 0, 0};
+    size_t size = s ? s->nbits : store_size();
+    for (size_t i = 0; i < size; ++i) {
+        if (s && !((s->bits[i >> 6] >> (i & 63)) & 1)) continue;
+        const Vec *e = store_at(i);
+        if (!e->used) continue;
+        double f[4] = { e->v[0], e->v[1], e->v[2], store_mag(i) };
+        for (int c = 0; c < 4; ++c) {
+            if (!n || f[c] < lo[c]) lo[c] = f[c];
+            if (!n || f[c] > hi[c]) hi[c] = f[c];
+            sum[c] += f[c];
+        }
+        n++;
+    }
+    printf("count = %zu\n", n);
+    if (!n) return 1;
+    const char *label[4] = { "x", "y", "z", "mag" };
+    printf("%-4s %12s %12s %12s\n", "", "min", "max", "mean");
+    for (int c = 0; c < 4; ++c)
+        printf("%-4s %12.3f %12.3f %12.3f\n", label[c], lo[c], hi[c], sum[c] / (double)n);
+    return 1;
+}
+
+int sel_save(const char *ref, const char *fname) {
+    const Selection *s = resolve(ref);
+    if (!s) return 0;
+    size_t *rows = xcalloc(s->count, sizeof *rows), k = 0;
+    if (!rows) return 0;
+    FOR_EACH_BIT(s, i) rows[k++] = i;
+    int ok = save_csv_rows(fname, rows, k);
+    free(rows);
+    if (ok) printf("saved %zu vectors to %s\n", k, fname);
+    return ok;
+}
+
+int sel_delete(const char *ref) {
+    const Selection *s = resolve(ref);
+    if (!s) return 0;
+    size_t removed = store_delete(s->bits, s->nbits);
+    if (removed == VL_ERROR) return 0;
+    printf("deleted %zu vectors\n", removed);
+    return 1;
+}
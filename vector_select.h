@@ -0,0 +1,24 @@
+/* Filename: vector_select.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Named selections. A predicate is evaluated column by column
+ *              into a bitmap over store slots; the bitmap can then be used
+ *              by apply/stats/save/del as "@name".
+ */
+#ifndef VECTOR_SELECT_H
+#define VECTOR_SELECT_H
+
+/* select <name> where <field> <op> <value> [and|or ...]
+ * fields: x y z mag (ops < <= > >= == !=) and name (== != ^= prefix). */
+int  sel_define(const char *name, const char *pred);
+void sel_list(void);
+int  sel_drop(const char *name);
+void sel_free_all(void);
+
+/* ref is "@name", or NULL for the whole store (stats only). */
+int sel_apply(const char *ref, char op, const char *operand); // op is + - *
+int sel_stats(const char *ref);
+int sel_save(const char *ref, const char *fname);
+int sel_delete(const char *ref);
+
+#endif /* VECTOR_SELECT_H */
@@ -0,0 +1,355 @@
+/* Filename: vector_shm.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: shm_open/mmap segment holding the store for zero-copy readers.
+ *
+ * Segment layout (all positions are byte offsets from the segment start):
+ *     ShmHeader | names[capacity][NAME_LEN] | coords[capacity][3] | index[index_cap]
+ * index[] holds entry+1 (0 = empty), FNV-1a hashed with linear probing.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vector_update.h"
+#include "vector_shm.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define cpu_relax() _mm_pause()
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+#define SHM_MAGIC    0x54414d494e494d31ull   /* "1MINIMAT" */
+#define SHM_VERSION  1
+#define SHM_MIN_CAP  1024
+#define SHM_NAME_LEN 64
+#define READ_SPINS   100          /* busy checks before yielding the CPU */
+#define READ_WAIT_NS 50000000ll   /* then give up after 50 ms */
+
+typedef struct {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t name_len;        /* NAME_LEN of the writer */
+    atomic_uint_least64_t seq; /* odd while the writer is mid-update */
+    uint64_t map_size;        /* bytes; only ever grows */
+    uint64_t generation;      /* number of publishes */
+    uint64_t count;
+    uint64_t capacity;
+    uint64_t index_cap;       /* power of two */
+    uint64_t names_off, coords_off, index_off;
+} ShmHeader;
+
+typedef struct {
+    char   name[SHM_NAME_LEN];
+    int    fd;
+    void  *base;
+    size_t len;
+} Mapping;
+
+static Mapping pub = { "", -1, NULL, 0 };   /* writer */
+static Mapping att = { "", -1, NULL, 0 };   /* reader */
+
+static uint64_t hash_name(const char *s) {
+    uint64_t h = 1469598103934665603ull;   /* FNV-1a */
+    for (; *s; ++s) { h ^= (unsigned char)*s; h *= 1099511628211ull; }
+    return h;
+}
+
+/* shm_open wants "/name" */
+static void seg_name(const char *in, char *out) {
+    snprintf(out, SHM_NAME_LEN, "%s%s", in[0] == '/' ? "" : "/", in);
+}
+
+static void unmap(Mapping *m) {
+    if (m->base) munmap(m->base, m->len);
+    if (m->fd >= 0) close(m->fd);
+    m->base = NULL;
+    m->len = 0;
+    m->fd = -1;
+}
+
+/* ---------- writer ---------- */
+
+static size_t layout(uint64_t cap, uint64_t *names_off, uint64_t *coords_off,
+                     uint64_t *index_off, uint64_t *index_cap) {
+    uint64_t icap = 16;
+    while (icap < cap * 2) icap *= 2;
+    *names_off  = (sizeof(ShmHeader) + 63) & ~(uint64_t)63;
+    *coords_off = *names_off + cap * NAME_LEN;
+    *index_off  = *coords_off + cap * 3 * sizeof(double);
+    *index_cap  = icap;
+    return (size_t)(*index_off + icap * sizeof(uint64_t));
+}
+
+int shm_publish(const char *name) {
+    char seg[SHM_NAME_LEN];
+    if (name) seg_name(name, seg);
+    else if (pub.base) strcpy(seg, pub.name);
+    else { puts("Error: syntax: shm publish <name>"); return 0; }
+
+    if (!pub.base || strcmp(seg, pub.name) != 0) {
+        unmap(&pub);
+        pub.fd = shm_open(seg, O_CREAT | O_RDWR, 0644);
+        if (pub.fd < 0) { printf("Error: cannot open shared memory %s\n", seg); return 0; }
+        strcpy(pub.name, seg);
+        struct stat st;
+        if (fstat(pub.fd, &st) == 0 && st.st_size >= (off_t)sizeof(ShmHeader)) {
+            pub.len = (size_t)st.st_size;
+            pub.base = mmap(NULL, pub.len, PROT_READ | PROT_WRITE, MAP_SHARED, pub.fd, 0);
+            if (pub.base == MAP_FAILED) { pub.base = NULL; unmap(&pub); puts("Error: mmap failed"); return 0; }
+            if (((ShmHeader*)pub.base)->magic != SHM_MAGIC) { munmap(pub.base, pub.len); pub.base = NULL; pub.len = 0; }
+        }
+    }
+
+    size_t n = store_size();
+    ShmHeader *h = (ShmHeader*)pub.base;
+
+    /* Grow (never shrink) when the current layout cannot hold n vectors.
+     * Readers notice map_size changed and remap once. */
+    uint64_t cap = h ? h->capacity : 0;
+    uint64_t names_off, coords_off, index_off, index_cap;
+    if (!h || n > cap) {
+        cap = n + n / 2 > SHM_MIN_CAP ? n + n / 2 : SHM_MIN_CAP;
+        size_t len = layout(cap, &names_off, &coords_off, &index_off, &index_cap);
+        if (len < pub.len) len = pub.len;
+        if (ftruncate(pub.fd, (off_t)len) != 0) { puts("Error: cannot size shared memory"); return 0; }
+        void *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, pub.fd, 0);
+        if (base == MAP_FAILED) { puts("Error: mmap failed"); return 0; }
+        if (pub.base) munmap(pub.base, pub.len);
+        pub.base = base;
+        pub.len = len;
+        h = (ShmHeader*)base;
+        if (h->magic != SHM_MAGIC) {
+            memset(h, 0, sizeof *h);
+            h->magic = SHM_MAGIC;
+            h->version = SHM_VERSION;
+            h->name_len = NAME_LEN;
+        }
+    } else {
+        names_off = h->names_off;
+        coords_off = h->coords_off;
+        index_off = h->index_off;
+        index_cap = h->index_cap;
+    }
+
+    char     *names  = (char*)pub.base + names_off;
+    double   *coords = (double*)((char*)pub.base + coords_off);
+    uint64_t *index  = (uint64_t*)((char*)pub.base + index_off);
+
+    /* seqlock write side: odd -> write everything -> even. An odd seq here
+     * means a writer died mid-publish; this publish rewrites everything, so
+     * step past it and readers recover once it ends. */
+    uint64_t s = atomic_load_explicit(&h->seq, memory_order_relaxed);
+    if (s & 1) s++;
+    atomic_store_explicit(&h->seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    memset(index, 0, index_cap * sizeof *index);
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const Vec *e = store_at(i);
+        if (!e->used) continue;
+        memcpy(names + k * NAME_LEN, e->name, NAME_LEN);
+        memcpy(coords + k * 3, e->v, sizeof e->v);
+        uint64_t p = hash_name(e->name) & (index_cap - 1);
+        while (index[p]) p = (p + 1) & (index_cap - 1);
+        index[p] = k + 1;
+        k++;
+    }
+    h->map_size = pub.len;
+    h->count = k;
+    h->capacity = cap;
+    h->index_cap = index_cap;
+    h->names_off = names_off;
+    h->coords_off = coords_off;
+    h->index_off = index_off;
+    h->generation++;
+
+    atomic_store_explicit(&h->seq, s + 2, memory_order_release);
+    printf("published %zu vectors to %s (generation %llu)\n", k, pub.name,
+           (unsigned long long)h->generation);
+    return 1;
+}
+
+int shm_unlink_segment(const char *name) {
+    char seg[SHM_NAME_LEN];
+    seg_name(name, seg);
+    if (strcmp(seg, pub.name) == 0) { unmap(&pub); pub.name[0] = '\0'; }
+    if (shm_unlink(seg) != 0) { printf("Error: cannot unlink %s\n", seg); return 0; }
+    return 1;
+}
+
+/* ---------- reader ---------- */
+
+static int map_reader(size_t len) {
+    void *base = mmap(NULL, len, PROT_READ, MAP_SHARED, att.fd, 0);
+    if (base == MAP_FAILED) return 0;
+    if (att.base) munmap(att.base, att.len);
+    att.base = base;
+    att.len = len;
+    return 1;
+}
+
+int shm_attach(const char *name) {
+    char seg[SHM_NAME_LEN];
+    seg_name(name, seg);
+    shm_detach();
+
+    att.fd = shm_open(seg, O_RDONLY, 0);
+    if (att.fd < 0) { printf("Error: no shared memory segment %s\n", seg); return 0; }
+    struct stat st;
+    if (fstat(att.fd, &st) != 0 || st.st_size < (off_t)sizeof(ShmHeader) || !map_reader((size_t)st.st_size)) {
+        printf("Error: %s is not a vector segment\n", seg);
+        unmap(&att);
+        return 0;
+    }
+    const ShmHeader *h = (const ShmHeader*)att.base;
+    if (h->magic != SHM_MAGIC || h->version != SHM_VERSION || h->name_len != NAME_LEN) {
+        printf("Error: %s is not a compatible vector segment\n", seg);
+        unmap(&att);
+        return 0;
+    }
+    strcpy(att.name, seg);
+    printf("attached %s (%llu vectors)\n", seg, (unsigned long long)h->count);
+    return 1;
+}
+
+void shm_detach(void) {
+    unmap(&att);
+    att.name[0] = '\0';
+}
+
+static long long since_ns(const struct timespec *t0) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (long long)(t.tv_sec - t0->tv_sec) * 1000000000ll + (t.tv_nsec - t0->tv_nsec);
+}
+
+/* Start a read section: *seq gets the even sequence number, after remapping
+ * if the writer grew the segment (the only path that makes a syscall).
+ * While the writer is mid-update we spin briefly, then yield. Returns 0 if
+ * it stays busy past READ_WAIT_NS: a writer that died while publishing
+ * leaves seq odd until the next publish to the segment, and callers report
+ * "not found" rather than hang. */
+static int read_begin(const ShmHeader **hp, uint64_t *seq) {
+    struct timespec t0;
+    for (unsigned spins = 0;; ++spins) {
+        const ShmHeader *h = (const ShmHeader*)att.base;
+        uint64_t s = atomic_load_explicit(&((ShmHeader*)h)->seq, memory_order_acquire);
+        if (s & 1) {                         /* writer busy */
+            if (spins < READ_SPINS) { cpu_relax(); continue; }
+            if (spins == READ_SPINS) clock_gettime(CLOCK_MONOTONIC, &t0);
+            else if (since_ns(&t0) > READ_WAIT_NS) return 0;
+            sched_yield();
+            continue;
+        }
+        uint64_t size = h->map_size;
+        if (size > att.len && map_reader((size_t)size)) continue;
+        *hp = h;
+        *seq = s;
+        return 1;
+    }
+}
+
+static int read_retry(const ShmHeader *h, uint64_t s) {
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&((ShmHeader*)h)->seq, memory_order_relaxed) != s;
+}
+
+int shm_lookup(const char *name, double out[3]) {
+    if (!att.base) return 0;
+    uint64_t hv = hash_name(name);
+    int found;
+    const ShmHeader *h;
+    uint64_t s;
+    do {
+        if (!read_begin(&h, &s)) return 0;   /* writer stuck mid-publish */
+        found = 0;
+        uint64_t cap = h->index_cap, count = h->count;
+        /* Bounds come from a possibly torn header; check before touching data. */
+        if (!cap || (cap & (cap - 1)) || h->index_off + cap * sizeof(uint64_t) > att.len ||
+            h->coords_off + count * 3 * sizeof(double) > att.len ||
+            h->names_off + count * NAME_LEN > att.len)
+            continue;
+        const char     *names  = (const char*)att.base + h->names_off;
+        const double   *coords = (const double*)((const char*)att.base + h->coords_off);
+        const uint64_t *index  = (const uint64_t*)((const char*)att.base + h->index_off);
+        uint64_t p = hv & (cap - 1);
+        for (uint64_t probes = 0; probes < cap && index[p]; ++probes, p = (p + 1) & (cap - 1)) {
+            uint64_t k = index[p] - 1;
+            if (k < count && strncmp(names + k * NAME_LEN, name, NAME_LEN) == 0) {
+                memcpy(out, coords + k * 3, 3 * sizeof(double));
+                found = 1;
+                break;
+            }
+        }
+    } while (read_retry(h, s));
+    return found;
+}
+
+void shm_list(void) {
+    if (!att.base) { puts("Error: not attached (shm attach <name>)"); return; }
+    const ShmHeader *h;
+    uint64_t s, count;
+    Vec *rows = NULL;
+    do {
+        if (!read_begin(&h, &s)) {
+            puts("Error: segment is mid-update (writer busy or gone); publish again to repair it.");
+            free(rows);
+            return;
+        }
+        count = h->count;
+        if (h->names_off + count * NAME_LEN > att.len ||
+            h->coords_off + count * 3 * sizeof(double) > att.len) continue;
+        free(rows);
+        rows = (Vec*)malloc((count ? count : 1) * sizeof *rows);
+        if (!rows) { puts("Error: out of memory."); return; }
+        for (uint64_t k = 0; k < count; ++k) {
+            memcpy(rows[k].name, (const char*)att.base + h->names_off + k * NAME_LEN, NAME_LEN);
+            rows[k].name[NAME_LEN - 1] = '\0';
+            memcpy(rows[k].v, (const char*)att.base + h->coords_off + k * 3 * sizeof(double), sizeof rows[k].v);
+        }
+    } while (read_retry(h, s));
+    for (uint64_t k = 0; k < count; ++k) vl_print_vec(rows[k].name, rows[k].v);
+    if (!count) puts("(no vectors stored)");
+    free(rows);
+}
+
+void shm_info(void) {
+    if (pub.base) {
+        const ShmHeader *h = (const ShmHeader*)pub.base;
+        printf("publishing %s: %llu vectors, capacity %llu, %zu bytes, generation %llu\n",
+               pub.name, (unsigned long long)h->count, (unsigned long long)h->capacity,
+               pub.len, (unsigned long long)h->generation);
+    }
+    if (att.base) {
+        const ShmHeader *h;
+        uint64_t s, count, gen, size;
+        do {
+            if (!read_begin(&h, &s)) {
+                printf("attached %s: mid-update (writer busy or gone)\n", att.name);
+                return;
+            }
+            count = h->count; gen = h->generation; size = h->map_size;
+        } while (read_retry(h, s));
+        printf("attached %s: %llu vectors, %llu bytes, generation %llu\n", att.name,
+               (unsigned long long)count, (unsigned long long)size, (unsigned long long)gen);
+    }
+    if (!pub.base && !att.base) puts("(no shared memory segments)");
+}
+
+void shm_close_all(void) {
+    unmap(&pub);
+    unmap(&att);
+}
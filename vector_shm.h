@@ -0,0 +1,25 @@
+/* Filename: vector_shm.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: POSIX shared-memory copy of the store. One writer publishes
+ *              names, coordinates and a hash index into a segment that uses
+ *              offsets only; readers map it and look vectors up in place,
+ *              retrying on a sequence lock instead of taking a syscall.
+ */
+#ifndef VECTOR_SHM_H
+#define VECTOR_SHM_H
+
+/* Writer side */
+int shm_publish(const char *name);   // NULL = republish to the last name
+int shm_unlink_segment(const char *name);
+
+/* Reader side */
+int  shm_attach(const char *name);
+void shm_detach(void);
+int  shm_lookup(const char *name, double out[3]); // 0 if not attached / not found
+void shm_list(void);
+
+void shm_info(void);
+void shm_close_all(void);
+
+#endif /* VECTOR_SHM_H */
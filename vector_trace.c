@@ -0,0 +1,319 @@
+/* Filename: vector_trace.c
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: --record / --replay and the gen command (synthetic stores and
+ *              command mixes) for reproducing performance problems.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "vector_update.h"
+#include "vector_trace.h"
+
+#define TRACE_LINE 512
+#define GEN_BATCH  4096
+
+/* ---------- clock ---------- */
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_until(uint64_t t) {
+    uint64_t now;
+    while ((now = now_ns()) < t) {
+        uint64_t d = t - now;
+        struct timespec ts = { (time_t)(d / 1000000000ull), (long)(d % 1000000000ull) };
+        nanosleep(&ts, NULL);
+    }
+}
+
+/* ---------- recording ---------- */
+
+static FILE *rec_fp = NULL;
+static uint64_t rec_t0 = 0;
+
+int trace_record_open(const char *fname) {
+    rec_fp = fopen(fname, "w");
+    if (!rec_fp) { printf("Error: cannot open %s\n", fname); return 0; }
+    rec_t0 = now_ns();
+    fputs("# minimat trace v1\n", rec_fp);
+    return 1;
+}
+
+void trace_record(const char *line) {
+    if (!rec_fp) return;
+    fprintf(rec_fp, "%llu\t%s\n", (unsigned long long)(now_ns() - rec_t0), line);
+}
+
+void trace_record_close(void) {
+    if (rec_fp) fclose(rec_fp);
+    rec_fp = NULL;
+}
+
+/* ---------- replay ---------- */
+
+typedef struct {
+    char      name[16];
+    uint64_t *lat;
+    size_t    n, cap;
+} TypeStats;
+
+/* NULL if memory runs out; the sample is then left out of the report. */
+static TypeStats *stats_for(TypeStats **types, size_t *ntypes, const char *name) {
+    for (size_t i = 0; i < *ntypes; ++i)
+        if (strcmp((*types)[i].name, name) == 0) return &(*types)[i];
+    TypeStats *t = (TypeStats*)realloc(*types, (*ntypes + 1) * sizeof *t);
+    if (!t) return NULL;
+    *types = t;
+    TypeStats *s = &t[(*ntypes)++];
+    memset(s, 0, sizeof *s);
+    snprintf(s->name, sizeof s->name, "%s", name);
+    return s;
+}
+
+/* 0 if there is no room for the sample. */
+static int add_sample(TypeStats *s, uint64_t ns) {
+    if (!s) return 0;
+    if (s->n == s->cap) {
+        size_t newcap = s->cap ? s->cap * 2 : 64;
+        uint64_t *t = (uint64_t*)realloc(s->lat, newcap * sizeof *t);
+        if (!t) return 0;
+        s->lat = t;
+        s->cap = newcap;
+    }
+    s->lat[s->n++] = ns;
+    return 1;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static double pct_us(const uint64_t *sorted, size_t n, double p) {
+    size_t i = (size_t)(p * (double)(n - 1) + 0.5);
+    return (double)sorted[i] / 1000.0;
+}
+
+static void report(TypeStats *types, size_t ntypes, size_t total, uint64_t wall) {
+    printf("replayed %zu commands in %.3f s (%.0f cmds/s wall)\n",
+           total, (double)wall / 1e9, wall ? (double)total * 1e9 / (double)wall : 0.0);
+    printf("%-12s %10s %12s %10s %10s %10s %10s\n",
+           "type", "count", "ops/s", "p50(us)", "p99(us)", "p99.9(us)", "max(us)");
+    for (size_t i = 0; i < ntypes; ++i) {
+        TypeStats *s = &types[i];
+        if (!s->n) continue;
+        uint64_t sum = 0;
+        for (size_t k = 0; k < s->n; ++k) sum += s->lat[k];
+        qsort(s->lat, s->n, sizeof *s->lat, cmp_u64);
+        printf("%-12s %10zu %12.0f %10.2f %10.2f %10.2f %10.2f\n", s->name, s->n,
+               sum ? (double)s->n * 1e9 / (double)sum : 0.0,
+               pct_us(s->lat, s->n, 0.50), pct_us(s->lat, s->n, 0.99),
+               pct_us(s->lat, s->n, 0.999), (double)s->lat[s->n - 1] / 1000.0);
+    }
+}
+
+int trace_replay(const char *fname, int paced, int echo, trace_exec_fn exec, trace_class_fn classify) {
+    FILE *fp = fopen(fname, "r");
+    if (!fp) { printf("Error: cannot open %s\n", fname); return 0; }
+
+    /* Command output would dominate the timings; send it to /dev/null. */
+    int saved = -1;
+    fflush(stdout);
+    if (!echo) {
+        int devnull = open("/dev/null", O_WRONLY);
+        if (devnull >= 0) { saved = dup(STDOUT_FILENO); dup2(devnull, STDOUT_FILENO); close(devnull); }
+    }
+
+    TypeStats *types = NULL;
+    size_t ntypes = 0, total = 0, dropped = 0;
+    char line[TRACE_LINE], cmd[TRACE_LINE], type[16];
+    uint64_t t0 = now_ns();
+
+    while (fgets(line, sizeof line, fp)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        char *tab = strchr(line, '\t');
+        if (!tab) continue;
+        size_t n = strlen(tab + 1);
+        while (n && isspace((unsigned char)tab[n])) tab[n--] = '\0';
+        if (!tab[1]) continue;
+
+        if (paced) sleep_until(t0 + strtoull(line, NULL, 10));
+        classify(tab + 1, type, sizeof type);
+        strcpy(cmd, tab + 1);
+
+        uint64_t start = now_ns();
+        int keep_going = exec(cmd);
+        if (!add_sample(stats_for(&types, &ntypes, type), now_ns() - start)) dropped++;
+        total++;
+        if (!keep_going) break;
+    }
+    uint64_t wall = now_ns() - t0;
+    fclose(fp);
+
+    fflush(stdout);
+    if (saved >= 0) { dup2(saved, STDOUT_FILENO); close(saved); }
+
+    if (dropped) printf("Error: out of memory; %zu commands left out of the latency report.\n", dropped);
+    report(types, ntypes, total, wall);
+    for (size_t i = 0; i < ntypes; ++i) free(types[i].lat);
+    free(types);
+    return 1;
+}
+
+/* ---------- generator ---------- */
+
+static uint64_t rng_state = 88172645463325252ull;
+
+static uint64_t rng_next(void) {         /* xorshift64 */
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static double rng_unit(void) { return (double)(rng_next() >> 11) * (1.0 / 9007199254740992.0); }
+
+static void rng_seed(unsigned long s) { rng_state = s ? (uint64_t)s * 2654435761ull + 1 : 88172645463325252ull; }
+
+/* Look up key=value among the option tokens; returns the value or NULL. */
+static const char *opt(const char *args, const char *key) {
+    size_t klen = strlen(key);
+    for (const char *p = args; (p = strstr(p, key)) != NULL; p += klen)
+        if ((p == args || p[-1] == ' ') && p[klen] == '=') return p + klen + 1;
+    return NULL;
+}
+
+static unsigned long opt_ul(const char *args, const char *key, unsigned long dflt) {
+    const char *v = opt(args, key);
+    return v ? strtoul(v, NULL, 10) : dflt;
+}
+
+static int gen_store(const char *args) {
+    unsigned long n = 0;
+    if (sscanf(args, "%lu", &n) != 1 || !n) { puts("Error: syntax: gen store <n> [prefix=v] [seed=1]"); return 0; }
+    char prefix[NAME_LEN - 20] = "v";
+    const char *p = opt(args, "prefix");
+    if (p) sscanf(p, "%11[A-Za-z0-9_]", prefix);
+    rng_seed(opt_ul(args, "seed", 1));
+
+    Vec *batch = (Vec*)malloc(GEN_BATCH * sizeof *batch);
+    if (!batch) { puts("Error: out of memory."); return 0; }
+    size_t added = 0;
+    for (unsigned long i = 0; i < n; ) {
+        size_t k = 0;
+        for (; k < GEN_BATCH && i < n; ++k, ++i) {
+            batch[k].used = 1;
+            snprintf(batch[k].name, NAME_LEN, "%s%lu", prefix, i);
+            for (int c = 0; c < 3; ++c) batch[k].v[c] = rng_unit() * 200.0 - 100.0;
+        }
+        size_t r = append_rows(batch, k, 1);
+        if (r == VL_ERROR) {
+            free(batch);
+            printf("generated %lu of %lu vectors (%zu new)\n", i - k, n, added);
+            return 0;
+        }
+        added += r;
+    }
+    free(batch);
+    printf("generated %lu vectors (%zu new)\n", n, added);
+    return 1;
+}
+
+enum { OP_SET, OP_GET, OP_ADD, OP_SUB, OP_DOT, OP_CROSS, OP_SELECT, OP_TOP, OP_SORT, NUM_OPS };
+static const char *op_names[NUM_OPS] = { "set", "get", "add", "sub", "dot", "cross", "select", "top", "sort" };
+static const unsigned long op_default[NUM_OPS] = { 40, 30, 10, 5, 5, 5, 3, 1, 1 };
+
+/* Zipf(s=1) over names: cdf[i] = sum_{k<=i} 1/(k+1), normalized. */
+static size_t pick_name(const double *cdf, size_t names) {
+    if (!cdf) return (size_t)(rng_next() % names);
+    double u = rng_unit();
+    size_t lo = 0, hi = names - 1;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (cdf[mid] < u) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+static int gen_trace(const char *args) {
+    char fname[256] = {0};
+    unsigned long ncmds = 0;
+    if (sscanf(args, "%255s %lu", fname, &ncmds) != 2 || !ncmds) {
+        puts("Error: syntax: gen trace <file> <ncmds> [names=N] [dist=uniform|zipf] [rate=R] [seed=S] [<op>=weight ...]");
+        return 0;
+    }
+    unsigned long names = opt_ul(args, "names", 1000);
+    unsigned long rate  = opt_ul(args, "rate", 1000);
+    unsigned long seed  = opt_ul(args, "seed", 1);
+    const char *dist = opt(args, "dist");
+    int zipf = dist && strncmp(dist, "zipf", 4) == 0;
+    if (!names) names = 1;
+    if (!rate) rate = 1;
+
+    unsigned long w[NUM_OPS], wsum = 0;
+    for (int i = 0; i < NUM_OPS; ++i) wsum += (w[i] = opt_ul(args, op_names[i], op_default[i]));
+    if (!wsum) { puts("Error: all operation weights are zero."); return 0; }
+
+    double *cdf = NULL;
+    if (zipf) {
+        cdf = (double*)malloc(names * sizeof *cdf);
+        if (!cdf) { puts("Error: out of memory."); return 0; }
+        double sum = 0.0;
+        for (unsigned long i = 0; i < names; ++i) cdf[i] = (sum += 1.0 / (double)(i + 1));
+        for (unsigned long i = 0; i < names; ++i) cdf[i] /= sum;
+    }
+
+    FILE *fp = fopen(fname, "w");
+    if (!fp) { printf("Error: cannot open %s\n", fname); free(cdf); return 0; }
+    rng_seed(seed);
+    fputs("# minimat trace v1\n", fp);
+    fprintf(fp, "0\tgen store %lu prefix=v seed=%lu\n", names, seed);
+
+    static const char *keys[] = { "mag", "x", "y", "z", "name" };
+    double t = 0.0;
+    for (unsigned long c = 0; c < ncmds; ++c) {
+        t += -log(1.0 - rng_unit()) / (double)rate;   /* Poisson arrivals */
+        unsigned long r = rng_next() % wsum;
+        int op = 0;
+        while (r >= w[op]) r -= w[op++];
+
+        size_t a = pick_name(cdf, names), b = pick_name(cdf, names), d = pick_name(cdf, names);
+        fprintf(fp, "%llu\t", (unsigned long long)(t * 1e9));
+        switch (op) {
+            case OP_SET:    fprintf(fp, "v%zu = %.3f %.3f %.3f\n", a,
+                                    rng_unit() * 200 - 100, rng_unit() * 200 - 100, rng_unit() * 200 - 100); break;
+            case OP_GET:    fprintf(fp, "v%zu\n", a); break;
+            case OP_ADD:    fprintf(fp, "v%zu = v%zu + v%zu\n", d, a, b); break;
+            case OP_SUB:    fprintf(fp, "v%zu = v%zu - v%zu\n", d, a, b); break;
+            case OP_DOT:    fprintf(fp, "dot v%zu v%zu\n", a, b); break;
+            case OP_CROSS:  fprintf(fp, "cross v%zu v%zu\n", a, b); break;
+            case OP_SELECT: fprintf(fp, "select s%lu where x > %.1f and z < %.1f\n", c % 8,
+                                    rng_unit() * 200 - 100, rng_unit() * 200 - 100); break;
+            case OP_TOP:    fprintf(fp, "top 10 by %s\n", keys[rng_next() % 4]); break;
+            case OP_SORT:   fprintf(fp, "sort by %s\n", keys[rng_next() % 5]); break;
+        }
+    }
+    fclose(fp);
+    free(cdf);
+    printf("wrote %lu commands over %lu names (%s) to %s\n", ncmds, names, zipf ? "zipf" : "uniform", fname);
+    return 1;
+}
+
+int gen_command(const char *args) {
+    if (strncmp(args, "store ", 6) == 0) return gen_store(args + 6);
+    if (strncmp(args, "trace ", 6) == 0) return gen_trace(args + 6);
+    puts("Error: syntax: gen store <n> ... | gen trace <file> <ncmds> ...");
+    return 0;
+}
@@ -0,0 +1,38 @@
+/* Filename: vector_trace.h
+ * Author: Caleb Wilson
+ * Date: 10/19/25
+ * Description: Session recording, synthetic workload generation and timed
+ *              replay with per-command latency statistics.
+ *
+ * Trace format (text, one command per line):
+ *     # minimat trace v1
+ *     <nanoseconds since session start>\t<command line>
+ */
+#ifndef VECTOR_TRACE_H
+#define VECTOR_TRACE_H
+
+#include <stddef.h>
+
+/* Runs one command line; returns 0 when the line asks to quit. */
+typedef int (*trace_exec_fn)(char *line);
+
+/* Names the report group of a command line ("assign", "expr", "print" or
+ * the command word), using the same command table as exec. */
+typedef void (*trace_class_fn)(const char *line, char *out, size_t outsz);
+
+/* Recording (--record <file>) */
+int  trace_record_open(const char *fname);
+void trace_record(const char *line);
+void trace_record_close(void);
+
+/* Replay (--replay <file>): paced = honor recorded timestamps,
+ * echo = keep command output instead of discarding it. Prints a report. */
+int trace_replay(const char *fname, int paced, int echo, trace_exec_fn exec, trace_class_fn classify);
+
+/* gen store <n> [prefix=v] [seed=1]
+ * gen trace <file> <ncmds> [names=N] [dist=uniform|zipf] [rate=R] [seed=S]
+ *           [set=W] [get=W] [add=W] [sub=W] [dot=W] [cross=W]
+ *           [select=W] [top=W] [sort=W] */
+int gen_command(const char *args);
+
+#endif /* VECTOR_TRACE_H */
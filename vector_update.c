@@ -1,168 +1,161 @@
 /* Filename: vector_update.c
  * Author: Caleb Wilson
  * Date: 10/19/25
- * Description: Lab 7 dynamic storage (+ CSV) with Lab 5 math API.
+ * Description: The program's store: one libvector handle shared by the REPL
+ *              modules, plus the error messages they print.
  */
 
 #include <stdio.h>
-#include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
+#include <string.h>
 #include "vector_update.h"
 
-typedef struct {
-    Vec   *data;
-    size_t size;
-    size_t capacity;
-} VecStore;
-
-static VecStore g = { NULL, 0, 0 };
-
-static void ensure_capacity(size_t need) {
-    if (need <= g.capacity) return;
-    size_t newcap = g.capacity ? g.capacity * 2 : 8;
-    if (newcap < need) newcap = need;
-    Vec *tmp = (Vec*)realloc(g.data, newcap * sizeof *tmp);
-    if (!tmp) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
-    for (size_t i = g.capacity; i < newcap; ++i) {
-        tmp[i].used = 0;
-        tmp[i].name[0] = '\0';
-        tmp[i].v[0] = tmp[i].v[1] = tmp[i].v[2] = 0.0;
-    }
-    g.data = tmp;
-    g.capacity = newcap;
+static vl_store *db = NULL;
+
+/* The library reports out-of-memory and leaves the store as it was; the
+ * command just fails with this message. */
+static int check(int r) {
+    if (r != VL_ENOMEM) return r;
+    puts("Error: out of memory.");
+    return 0;
+}
+
+static size_t check_count(size_t n) {
+    if (n == VL_ERROR) puts("Error: out of memory.");
+    return n;
 }
 
 void init_store(void) {
-    g.data = NULL;
-    g.size = 0;
-    g.capacity = 0;
+    if (!db && !(db = vl_open())) { fprintf(stderr, "Error: out of memory\n"); exit(1); }
 }
 
 void free_store(void) {
-    free(g.data);
-    g.data = NULL;
-    g.size = 0;
-    g.capacity = 0;
+    vl_close(db);
+    db = NULL;
 }
 
-void clear_store(void) {
-    /* Reset to empty but keep capacity to avoid churn */
-    for (size_t i = 0; i < g.size; ++i) g.data[i].used = 0;
-    g.size = 0;
-}
+/* ----- Storage ----- */
 
-static int find_index(const char *name) {
-    for (size_t i = 0; i < g.size; ++i)
-        if (g.data[i].used && strcmp(g.data[i].name, name) == 0) return (int)i;
-    return -1;
-}
+void clear_store(void) { vl_clear(db); }
+void list_store(void)  { vl_list(db); }
 
 int set_vector(const char *name, double x, double y, double z) {
-    int idx = find_index(name);
-    if (idx >= 0) {
-        g.data[idx].v[0] = x; g.data[idx].v[1] = y; g.data[idx].v[2] = z;
-        return 1;
-    }
-    ensure_capacity(g.size + 1);
-    g.data[g.size].used = 1;
-    strncpy(g.data[g.size].name, name, NAME_LEN - 1);
-    g.data[g.size].name[NAME_LEN - 1] = '\0';
-    g.data[g.size].v[0] = x; g.data[g.size].v[1] = y; g.data[g.size].v[2] = z;
-    g.size++;
-    return 1;
+    double v[3] = {x, y, z};
+    return check(vl_set(db, name, v));
 }
 
-int get_vector(const char *name, double out[3]) {
-    int idx = find_index(name);
-    if (idx < 0) return 0;
-    out[0] = g.data[idx].v[0];
-    out[1] = g.data[idx].v[1];
-    out[2] = g.data[idx].v[2];
-    return 1;
+int get_vector(const char *name, double out[3]) { return vl_get(db, name, out); }
+int get_mag(const char *name, double *out)      { return vl_mag(db, name, out); }
+int del_vector(const char *name)                { return check(vl_del(db, name)); }
+
+/* The process has one store, so the callback needs no context. */
+static int (*fallback)(const char *name, double out[3]);
+
+static int call_fallback(void *ctx, const char *name, double out[3]) {
+    (void)ctx;
+    return fallback(name, out);
 }
 
-void list_store(void) {
-    int any = 0;
-    for (size_t i = 0; i < g.size; ++i) {
-        if (g.data[i].used) {
-            print_vec_named(g.data[i].name, g.data[i].v);
-            any = 1;
-        }
-    }
-    if (!any) puts("(no vectors stored)");
+void store_set_fallback(int (*fn)(const char *name, double out[3])) {
+    fallback = fn;
+    vl_set_fallback(db, fn ? call_fallback : NULL, NULL);
 }
 
-/* ----- Vector math ----- */
+size_t append_rows(const Vec *rows, size_t n, int keep_last) { return check_count(vl_append(db, rows, n, keep_last)); }
 
-void v_add(const double a[3], const double b[3], double r[3]) {
-    r[0] = a[0] + b[0]; r[1] = a[1] + b[1]; r[2] = a[2] + b[2];
-}
+vl_store *store_staging(void)           { return vl_open_like(db); }
+void      store_swap_in(vl_store *staged) { vl_swap(db, staged); }
 
-void v_sub(const double a[3], const double b[3], double r[3]) {
-    r[0] = a[0] - b[0]; r[1] = a[1] - b[1]; r[2] = a[2] - b[2];
-}
+size_t     store_size(void)                      { return vl_size(db); }
+long       store_find(const char *name)          { return vl_find(db, name); }
+const Vec *store_at(size_t i)                    { return vl_at(db, i); }
+int        store_permute(const size_t *order)    { return check(vl_permute(db, order)); }
+int        store_set_at(size_t i, const double v[3]) { return check(vl_set_at(db, i, v)); }
+size_t     store_delete(const uint64_t *bits, size_t nbits) { return check_count(vl_delete(db, bits, nbits)); }
+unsigned long store_epoch(void)                  { return vl_epoch(db); }
 
-void v_scale(const double a[3], double s, double r[3]) {
-    r[0] = a[0] * s; r[1] = a[1] * s; r[2] = a[2] * s;
+double store_mag(size_t i)     { return vl_slot_mag(db, i); }
+void   store_mags(double *out) { vl_mags(db, out); }
+
+/* ----- Memory ----- */
+
+size_t store_shrink(void)          { return vl_shrink(db); }
+int    store_set_chunk(size_t vecs) { return vl_set_chunk(db, vecs); }
+void   store_set_huge(int mode)     { vl_set_huge(db, mode); }
+void   mem_report(void)             { vl_mem_report(db); }
+
+/* ----- Workspaces and checkpoints ----- */
+
+int ws_create(const char *name, int fork) {
+    int r = vl_ws_create(db, name, fork);
+    if (r) return check(r);
+    printf("Error: workspace %s already exists\n", name);
+    return 0;
 }
 
-double v_dot(const double a[3], const double b[3]) {
-    return a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+int ws_use(const char *name) {
+    if (vl_ws_use(db, name)) return 1;
+    printf("Error: no workspace named %s\n", name);
+    return 0;
 }
 
-void v_cross(const double a[3], const double b[3], double r[3]) {
-    r[0] = a[1]*b[2] - a[2]*b[1];
-    r[1] = a[2]*b[0] - a[0]*b[2];
-    r[2] = a[0]*b[1] - a[1]*b[0];
+int ws_drop(const char *name) {
+    if (strcmp(name, vl_ws_current(db)) == 0) { puts("Error: cannot drop the workspace in use."); return 0; }
+    if (vl_ws_drop(db, name)) return 1;
+    printf("Error: no workspace named %s\n", name);
+    return 0;
 }
 
-/* ----- Display ----- */
+void        ws_list(void)    { vl_ws_list(db); }
+const char *ws_current(void) { return vl_ws_current(db); }
 
-void print_vec_named(const char *name, const double v[3]) {
-    printf("%s = %.3f   %.3f   %.3f\n", name, v[0], v[1], v[2]);
+int checkpoint_create(const char *tag) { return check(vl_checkpoint_create(db, tag)); }
+
+int checkpoint_rollback(const char *tag) {
+    int r = vl_checkpoint_rollback(db, tag);
+    if (r) return check(r);
+    printf("Error: no checkpoint named %s in workspace %s\n", tag, vl_ws_current(db));
+    return 0;
+}
+
+int checkpoint_drop(const char *tag) {
+    if (vl_checkpoint_drop(db, tag)) return 1;
+    printf("Error: no checkpoint named %s in workspace %s\n", tag, vl_ws_current(db));
+    return 0;
 }
 
 /* ----- CSV ----- */
 
-static void trim_right(char *s) {
-    size_t n = strlen(s);
-    while (n && (unsigned char)s[n-1] <= ' ') s[--n] = '\0';
+static int read_csv(const char *fname, int clear_first, int keep_last, vl_csv_stats *st) {
+    int r = vl_load_csv(db, fname, clear_first, keep_last, st);
+    if (!r) {
+        printf("Error: cannot open %s\n", fname);
+        return 0;
+    }
+    if (st->bad) printf("Warning: %zu bad lines ignored\n", st->bad);
+    if (r == VL_ENOMEM) printf("Error: out of memory; loaded the first %zu rows of %s\n", st->rows, fname);
+    return 1;
 }
 
 int load_csv(const char *fname) {
-    FILE *fp = fopen(fname, "r");
-    if (!fp) { printf("Error: cannot open %s\n", fname); return 0; }
-
-    clear_store();
-
-    char line[256];
-    char name[NAME_LEN];
-    double x, y, z;
-
-    while (fgets(line, sizeof line, fp)) {
-        trim_right(line);
-        if (!*line) continue;
-        if (sscanf(line, "%31[^,],%lf,%lf,%lf", name, &x, &y, &z) == 4) {
-            set_vector(name, x, y, z);
-        } else {
-            printf("Warning: bad line ignored: %s\n", line);
-        }
-    }
+    vl_csv_stats st;
+    return read_csv(fname, 1, 1, &st);
+}
 
-    fclose(fp);
+int merge_csv(const char *fname, int keep_last) {
+    vl_csv_stats st;
+    if (!read_csv(fname, 0, keep_last, &st)) return 0;
+    printf("%zu rows read: %zu added, %zu duplicate names (kept %s)\n",
+           st.rows, st.added, st.rows - st.added, keep_last ? "last" : "first");
     return 1;
 }
 
 int save_csv(const char *fname) {
-    FILE *fp = fopen(fname, "w");
-    if (!fp) { printf("Error: Cannot open %s\n", fname); return 0; }
-    for (size_t i = 0; i < g.size; ++i) {
-        if (g.data[i].used) {
-            fprintf(fp, "%s,%.6f,%.6f,%.6f\n",
-                    g.data[i].name, g.data[i].v[0], g.data[i].v[1], g.data[i].v[2]);
-        }
-    }
-    fclose(fp);
-    return 1;
+    return save_csv_rows(fname, NULL, vl_size(db));
+}
+
+int save_csv_rows(const char *fname, const size_t *rows, size_t n) {
+    if (vl_save_csv(db, fname, rows, n)) return 1;
+    printf("Error: Cannot open %s\n", fname);
+    return 0;
 }
@@ -1,45 +1,84 @@
 /* Filename: vector_update.h
  * Author: Caleb Wilson
  * Date: 10/19/25
- * Description: Lab 7 dynamic storage + Lab 5 API surface.
+ * Description: Lab 7 dynamic storage + Lab 5 API surface. The program keeps
+ *              one process-wide libvector store; these calls forward to it
+ *              and print the messages the REPL shows.
  */
 #ifndef VECTOR_UPDATE_H
 #define VECTOR_UPDATE_H
 
-#include <stddef.h>
-
-#define NAME_LEN 32
-
-typedef struct {
-    int used;
-    char name[NAME_LEN];
-    double v[3];
-} Vec;
+#include "libvector.h"
 
 /* Init / teardown */
 void init_store(void);
 void free_store(void);
 
-/* Storage management */
+/* Storage management. Calls that add or change vectors print
+ * "Error: out of memory." if memory runs out and return 0 (VL_ERROR for
+ * the ones returning a count); see libvector.h for what is kept. */
 void clear_store(void);
 void list_store(void);
 int  set_vector(const char *name, double x, double y, double z);
 int  get_vector(const char *name, double out[3]);
+int  get_mag(const char *name, double *out);   // |v|, cached for stored vectors
+int  del_vector(const char *name);
+
+/* Consulted by get_vector when a name is not in the store (e.g. shm reader). */
+void store_set_fallback(int (*fn)(const char *name, double out[3]));
+
+/* Bulk insert: reserves room for n rows once, then resolves duplicate names
+ * with one hash probe per row. keep_last = 1 lets later rows overwrite.
+ * Returns the number of new names added, or VL_ERROR. */
+size_t append_rows(const Vec *rows, size_t n, int keep_last);
+
+/* Staging for background loads: an empty store with the same chunk policy,
+ * filled without the store lock, then swapped into the current workspace in
+ * one step (the staging store gets the old vectors; close it with vl_close).
+ * NULL if it cannot be allocated. */
+vl_store *store_staging(void);
+void      store_swap_in(vl_store *staged);
+
+/* Raw slot access, 0 .. store_size()-1 (check Vec.used) */
+size_t     store_size(void);
+long       store_find(const char *name);          // slot, or -1 (no fallback)
+const Vec *store_at(size_t i);
+int        store_permute(const size_t *order); // slot k <- old slot order[k]
+int        store_set_at(size_t i, const double v[3]);
+size_t     store_delete(const uint64_t *bits, size_t nbits); // compacts, returns count (or VL_ERROR)
+
+/* Changes when slots move or disappear (clear, sort, delete), not on append,
+ * so slot numbers taken under one epoch stay valid until it changes. */
+unsigned long store_epoch(void);
 
-/* Vector math (required) */
-void   v_add  (const double a[3], const double b[3], double r[3]);
-void   v_sub  (const double a[3], const double b[3], double r[3]);
-void   v_scale(const double a[3], double s,          double r[3]);
+/* Magnitudes are cached per slot and dropped whenever the slot is written
+ * (set_vector, apply, merge, ...); moves (sort, delete) keep them. */
+double store_mag(size_t i);
+void   store_mags(double *out);   // store_size() values, unused slots included
 
-/* Extra credit */
-double v_dot  (const double a[3], const double b[3]);              // scalar
-void   v_cross(const double a[3], const double b[3], double r[3]); // vector
+/* Memory: vectors live in fixed-size chunks, so growth never copies them.
+ * clear_store keeps capacity; store_shrink gives it back. */
+size_t store_shrink(void);          // returns bytes released
+int    store_set_chunk(size_t vecs); // rounded up to a power of two, re-lays out (VL_ENOMEM: size unchanged)
+void   store_set_huge(int mode);     // VL_HUGE_OFF / VL_HUGE_THP / VL_HUGE_ON
+void   mem_report(void);
 
-/* Display helper */
-void print_vec_named(const char *name, const double v[3]);
+/* Workspaces: independent named stores ("main" exists from the start).
+ * Checkpoints snapshot the current workspace by sharing its chunks; only
+ * chunks written afterwards get copied. */
+int         ws_create(const char *name, int fork); // fork = start as a copy of current
+int         ws_use(const char *name);
+int         ws_drop(const char *name);
+void        ws_list(void);
+const char *ws_current(void);
+int         checkpoint_create(const char *tag);    // same tag again replaces it
+int         checkpoint_rollback(const char *tag);  // checkpoint stays for reuse
+int         checkpoint_drop(const char *tag);
 
 /* CSV I/O */
 int load_csv(const char *fname); // clears store first
+int merge_csv(const char *fname, int keep_last); // keeps store, resolves duplicates
 int save_csv(const char *fname); // overwrites
+int save_csv_rows(const char *fname, const size_t *rows, size_t n); // rows in the given order
 
 #endif /* VECTOR_UPDATE_H */